@@ -1,8 +1,40 @@
 #include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <set>
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
 #include "filesystem.hpp"
+#include "stream_operations.hpp"
+#include "crc32c.hpp"
 
 using boost::filesystem::path;
 using boost::filesystem::directory_entry;
@@ -12,6 +44,19 @@ namespace
     void copy_path(const path&, const path&, const path&);
     std::pair<path, path> split(const path&, const path&);
     void copy_directories(const path&, const path&, const path&);
+    bool read_directory(const path&, const std::function<void(const char*, const boost::filesystem::file_type&, const std::uint64_t&)>&);
+    void copy_contents(const path&, const path&, std::atomic<std::uint64_t>&);
+    bool inspect(const path&, filesystem::tree_entry&, std::uint64_t* = nullptr);
+    bool crc_of(const path&, std::uint32_t&, const std::uint64_t& = std::numeric_limits<std::uint64_t>::max());
+    bool differs(const filesystem::tree_entry&, const filesystem::tree_entry&);
+    std::int64_t now();
+    void run_parallel(const std::size_t&, const unsigned int&, const std::function<void(const std::size_t&)>&);
+    bool same_contents(const path&, const path&);
+    std::vector<std::vector<path> > duplicates_in(filesystem::recursive_iterator, const unsigned int&);
+    bool is_within(const path&, const path&);
+    std::string parent_of(const std::string&);
+    template<typename type> void erase_within(std::map<std::string, type>&, const std::string&);
+    void add_usage(filesystem::usage&, const filesystem::usage&);
     
     
     /**
@@ -94,6 +139,474 @@ namespace
                 !exists(newdest)) copy(subpath, newdest);
     }
     
+#ifdef __linux__
+    struct linux_dirent64
+    {
+        std::uint64_t d_ino;
+        std::int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+    
+    inline boost::filesystem::file_type type_of(const mode_t& mode)
+    {
+        using namespace boost::filesystem;
+        
+        if(S_ISREG(mode)) return regular_file;
+        if(S_ISDIR(mode)) return directory_file;
+        if(S_ISLNK(mode)) return symlink_file;
+        if(S_ISBLK(mode)) return block_file;
+        if(S_ISCHR(mode)) return character_file;
+        if(S_ISFIFO(mode)) return fifo_file;
+        if(S_ISSOCK(mode)) return socket_file;
+        return type_unknown;
+    }
+    
+    inline boost::filesystem::file_type type_of(const unsigned char& d_type)
+    {
+        using namespace boost::filesystem;
+        
+        switch(d_type)
+        {
+            case DT_REG: return regular_file;
+            case DT_DIR: return directory_file;
+            case DT_LNK: return symlink_file;
+            case DT_BLK: return block_file;
+            case DT_CHR: return character_file;
+            case DT_FIFO: return fifo_file;
+            case DT_SOCK: return socket_file;
+            default: return status_unknown;
+        }
+    }
+#endif
+    
+    /**
+     * @brief Calls f with the name, type and inode of every entry in a folder.
+     * On Linux, the folder is read with getdents64 in large blocks, and only
+     * entries whose type the filesystem doesn't record are stat'ed.
+     * @return false if the folder couldn't be read.
+     */
+    bool read_directory(const path& folder, const std::function<void(const char*, const boost::filesystem::file_type&, const std::uint64_t&)>& f)
+    {
+#ifdef __linux__
+        int fd{::open(folder.c_str(), (O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC))};
+        std::vector<char> buffer(1 << 16);
+        long size;
+        
+        if(fd < 0) return false;
+        while((size = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size())) > 0)
+        {
+            for(long offset{0}; offset < size;)
+            {
+                const linux_dirent64* d{reinterpret_cast<const linux_dirent64*>(buffer.data() + offset)};
+                boost::filesystem::file_type type{type_of(d->d_type)};
+                
+                offset += d->d_reclen;
+                if((std::strcmp(d->d_name, ".") == 0) || (std::strcmp(d->d_name, "..") == 0)) continue;
+                if(type == boost::filesystem::status_unknown)
+                {
+                    struct stat st;
+                    type = ((::fstatat(fd, d->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) ? type_of(st.st_mode) : boost::filesystem::type_unknown);
+                }
+                f(d->d_name, type, d->d_ino);
+            }
+        }
+        ::close(fd);
+        return (size == 0);
+#else
+        boost::system::error_code error;
+        
+        for(boost::filesystem::directory_iterator it{folder, error}; !error && (it != boost::filesystem::directory_iterator{}); it.increment(error))
+        {
+            f(it->path().filename().string().c_str(), it->symlink_status().type(), 0);
+        }
+        return !error;
+#endif
+    }
+    
+    /**
+     * @brief Copies a file that doesn't exist yet, adding the bytes copied to
+     * "bytes" as it goes.  On Linux, the copy is made without passing the data
+     * through this process:  the file is cloned if the filesystem supports it
+     * (FICLONE), and otherwise copied with copy_file_range, or sendfile.
+     */
+    void copy_contents(const path& from, const path& to, std::atomic<std::uint64_t>& bytes)
+    {
+#ifdef __linux__
+        struct stat st;
+        int in{::open(from.c_str(), (O_RDONLY | O_CLOEXEC))}, out{-1};
+        bool copied{false};
+        
+        auto fail = [&](const char* what, const path& p)
+        {
+            int error{errno};
+            if(in >= 0) ::close(in);
+            if(out >= 0) ::close(out);
+            throw boost::filesystem::filesystem_error{what, p, boost::system::error_code{error, boost::system::system_category()}};
+        };
+        
+        if((in < 0) || (::fstat(in, &st) != 0)) fail("unable to read", from);
+        out = ::open(to.c_str(), (O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC), (st.st_mode & 07777));
+        if(out < 0) fail("unable to create", to);
+        
+#ifdef FICLONE
+        if(::ioctl(out, FICLONE, in) == 0)
+        {
+            bytes += st.st_size;
+            copied = true;
+        }
+#endif
+#ifdef SYS_copy_file_range
+        for(bool supported{true}; !copied && supported;)
+        {
+            long n{::syscall(SYS_copy_file_range, in, nullptr, out, nullptr, (1 << 30), 0)};
+            if(n > 0) bytes += n;
+            else if(n == 0) copied = true;
+            else if(errno == EINTR) continue;
+            else if((errno == EXDEV) || (errno == ENOSYS) || (errno == EINVAL) || (errno == EOPNOTSUPP)) supported = false;
+            else fail("unable to copy", to);
+        }
+#endif
+        while(!copied)
+        {
+            ssize_t n{::sendfile(out, in, nullptr, (1 << 30))};
+            if(n > 0) bytes += n;
+            else if(n == 0) copied = true;
+            else if(errno != EINTR) fail("unable to copy", to);
+        }
+        ::close(in);
+        if(::close(out) != 0) fail("unable to copy", to);
+#else
+        boost::filesystem::copy_file(from, to);
+        bytes += boost::filesystem::file_size(to);
+#endif
+    }
+    
+    /**
+     * @brief Sets e to what's known about p, without following symlinks.
+     * @param allocated If not null, set to the space allocated to p.
+     * @return false if p couldn't be stat'ed.
+     */
+    bool inspect(const path& p, filesystem::tree_entry& e, std::uint64_t* allocated)
+    {
+        e = filesystem::tree_entry{};
+#ifdef __linux__
+        struct stat st;
+        
+        if(::lstat(p.c_str(), &st) != 0) return false;
+        e.type = type_of(st.st_mode);
+        e.inode = st.st_ino;
+        if(S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) e.size = st.st_size;
+        e.modified = ((static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000) + st.st_mtim.tv_nsec);
+        if(allocated != nullptr) *allocated = (static_cast<std::uint64_t>(st.st_blocks) * 512);
+        return true;
+#else
+        boost::system::error_code error;
+        
+        e.type = boost::filesystem::symlink_status(p, error).type();
+        if(error || (e.type == boost::filesystem::file_not_found)) return false;
+        if(e.type == boost::filesystem::regular_file) e.size = boost::filesystem::file_size(p, error);
+        e.modified = (static_cast<std::int64_t>(boost::filesystem::last_write_time(p, error)) * 1000000000);
+        if(allocated != nullptr) *allocated = e.size;
+        return true;
+#endif
+    }
+    
+    /**
+     * @brief Computes the CRC-32C of a file's contents, or of its first "limit"
+     * bytes.
+     * @return false if the file couldn't be read.
+     */
+    bool crc_of(const path& p, std::uint32_t& crc, const std::uint64_t& limit)
+    {
+        std::ifstream in{p.string(), std::ios::binary};
+        std::vector<char> buffer(std::min<std::uint64_t>((1 << 20), limit));
+        std::uint64_t left{limit};
+        
+        crc = 0;
+        while((left > 0) && (in.read(buffer.data(), std::min<std::uint64_t>(buffer.size(), left)) || (in.gcount() > 0)))
+        {
+            crc = checksum::crc32c(buffer.data(), in.gcount(), crc);
+            left -= in.gcount();
+        }
+        return (((left == 0) || in.eof()) && !in.bad());
+    }
+    
+    /**
+     * @brief Whether an entry changed between two snapshots.  Folders only
+     * change if they were replaced;  their contents are compared separately.
+     * When both have a checksum, a file changed only if its contents did.
+     */
+    bool differs(const filesystem::tree_entry& a, const filesystem::tree_entry& b)
+    {
+        if(a.type != b.type) return true;
+        if(a.type == boost::filesystem::directory_file) return (a.inode != b.inode);
+        if(a.hashed && b.hashed) return ((a.size != b.size) || (a.crc != b.crc));
+        return ((a.inode != b.inode) || (a.size != b.size) || (a.modified != b.modified));
+    }
+    
+    /**
+     * @return The time, in nanoseconds since the epoch, as file modification
+     * times are measured.
+     */
+    std::int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    
+    /**
+     * @brief Calls f(0) through f(n - 1), spread across several threads.  If f
+     * throws, the calls that haven't started are skipped, and the exception is
+     * rethrown.
+     */
+    void run_parallel(const std::size_t& n, const unsigned int& threads, const std::function<void(const std::size_t&)>& f)
+    {
+        std::atomic<std::size_t> next{0};
+        std::mutex m;
+        std::exception_ptr error;
+        std::vector<std::thread> workers;
+        
+        auto work = [&]()
+        {
+            for(std::size_t x{next++}; x < n; x = next++)
+            {
+                try
+                {
+                    f(x);
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock{m};
+                    if(!error) error = std::current_exception();
+                    next = n;
+                }
+            }
+        };
+        
+        for(std::size_t x{0}; x < std::min<std::size_t>(n, ((threads > 0) ? threads : std::max(4u, std::thread::hardware_concurrency()))); ++x)
+        {
+            workers.emplace_back(work);
+        }
+        for(std::thread& t : workers) t.join();
+        if(error) std::rethrow_exception(error);
+    }
+    
+    /**
+     * @return true if two files have the same contents.
+     */
+    bool same_contents(const path& a, const path& b)
+    {
+        std::ifstream first{a.string(), std::ios::binary}, second{b.string(), std::ios::binary};
+        std::vector<char> x(1 << 20), y(1 << 20);
+        
+        if(!first.is_open() || !second.is_open()) return false;
+        while(true)
+        {
+            first.read(x.data(), x.size());
+            second.read(y.data(), y.size());
+            if(first.gcount() != second.gcount()) return false;
+            if(first.gcount() == 0) return (first.eof() && second.eof() && !first.bad() && !second.bad());
+            if(std::memcmp(x.data(), y.data(), first.gcount()) != 0) return false;
+        }
+    }
+    
+    /**
+     * @return true if p is folder, or is inside of it.
+     */
+    bool is_within(const path& p, const path& folder)
+    {
+        const std::string& s(p.native());
+        const std::string& f(folder.native());
+        
+        return ((s.compare(0, f.size(), f) == 0) && ((s.size() == f.size()) || (s[f.size()] == '/')));
+    }
+    
+    /**
+     * @return The relative path of the folder an entry is in;  "" for the root.
+     */
+    std::string parent_of(const std::string& relative)
+    {
+        std::string::size_type slash{relative.rfind('/')};
+        return ((slash == std::string::npos) ? std::string{} : relative.substr(0, slash));
+    }
+    
+    /**
+     * @brief Erases relative, and everything inside of it, from a map of
+     * relative paths.  What's inside a folder is always next to each other in
+     * the map, since it all starts with "folder/".
+     */
+    template<typename type>
+    void erase_within(std::map<std::string, type>& m, const std::string& relative)
+    {
+        if(relative.empty())
+        {
+            m.clear();
+            return;
+        }
+        m.erase(relative);
+        m.erase(m.lower_bound(relative + '/'), m.lower_bound(relative + static_cast<char>('/' + 1)));
+    }
+    
+    void add_usage(filesystem::usage& total, const filesystem::usage& u)
+    {
+        total.bytes += u.bytes;
+        total.allocated += u.allocated;
+        total.files += u.files;
+        total.newest = std::max(total.newest, u.newest);
+    }
+    
+    /**
+     * @brief Finds the files with the same contents among those visited by an
+     * iterator.  Candidates are narrowed down in stages, each more expensive than
+     * the last, but run on fewer files:  files are grouped by size, then by a
+     * checksum (CRC-32C) of their first 4 KiB, then by a checksum of their
+     * contents, and finally each file left is compared byte by byte with the
+     * first of its group.  Every stage spreads its reads across threads.
+     */
+    std::vector<std::vector<path> > duplicates_in(filesystem::recursive_iterator it, const unsigned int& threads)
+    {
+        constexpr std::uint64_t HEAD{4096};
+        
+        struct group
+        {
+            std::uint64_t size;
+            std::vector<path> files;
+        };
+        
+        std::map<std::uint64_t, std::vector<path> > by_size;
+        std::set<std::pair<std::uint64_t, std::uint64_t> > seen; //device and inode of each file, so hard links are counted once
+        std::vector<group> groups, confirmed;
+        std::vector<std::vector<path> > duplicates;
+        
+        for(; !it.end(); ++it)
+        {
+            if(!boost::filesystem::is_regular_file(it->symlink_status())) continue;
+#ifdef __linux__
+            struct stat st;
+            
+            if((::lstat(it->path().c_str(), &st) != 0) || (st.st_size == 0)) continue;
+            if(!seen.emplace(st.st_dev, st.st_ino).second) continue;
+            by_size[st.st_size].push_back(it->path());
+#else
+            boost::system::error_code error;
+            std::uint64_t size{boost::filesystem::file_size(it->path(), error)};
+            
+            if(!error && (size > 0)) by_size[size].push_back(it->path());
+#endif
+        }
+        for(std::pair<const std::uint64_t, std::vector<path> >& s : by_size)
+        {
+            if(s.second.size() > 1) groups.push_back(group{s.first, std::move(s.second)});
+        }
+        by_size.clear();
+        
+        //splits every group by the checksum of its files' first "limit" bytes:
+        auto split = [&groups, &threads](const std::uint64_t& limit)
+        {
+            std::vector<std::pair<std::size_t, std::size_t> > files;
+            std::vector<std::uint32_t> crcs;
+            std::vector<char> read;
+            std::vector<group> split_groups;
+            
+            for(std::size_t g{0}; g < groups.size(); ++g)
+            {
+                for(std::size_t f{0}; f < groups[g].files.size(); ++f) files.emplace_back(g, f);
+            }
+            crcs.resize(files.size());
+            read.resize(files.size());
+            run_parallel(files.size(), threads, [&](const std::size_t& x)
+            {
+                read[x] = crc_of(groups[files[x].first].files[files[x].second], crcs[x], limit);
+            });
+            
+            for(std::size_t x{0}; x < files.size();)
+            {
+                std::map<std::uint32_t, std::vector<path> > by_crc;
+                const std::size_t g{files[x].first};
+                
+                for(; (x < files.size()) && (files[x].first == g); ++x)
+                {
+                    if(read[x]) by_crc[crcs[x]].push_back(std::move(groups[g].files[files[x].second]));
+                }
+                for(std::pair<const std::uint32_t, std::vector<path> >& c : by_crc)
+                {
+                    if(c.second.size() > 1) split_groups.push_back(group{groups[g].size, std::move(c.second)});
+                }
+            }
+            groups = std::move(split_groups);
+        };
+        
+        split(HEAD);
+        if(std::any_of(groups.begin(), groups.end(), [](const group& g){ return (g.size > HEAD); }))
+        {
+            std::vector<group> small;
+            
+            //the first 4 KiB of a small file is all of it:
+            for(std::vector<group>::iterator g{groups.begin()}; g != groups.end();)
+            {
+                if(g->size > HEAD) ++g;
+                else
+                {
+                    small.push_back(std::move(*g));
+                    g = groups.erase(g);
+                }
+            }
+            split(std::numeric_limits<std::uint64_t>::max());
+            for(group& g : small) groups.push_back(std::move(g));
+        }
+        
+        /* A matching checksum isn't proof, so each file is compared once to the first
+         * file of its group.  The files that don't match (which takes a CRC collision)
+         * are compared again among themselves, until none are left. */
+        while(!groups.empty())
+        {
+            std::vector<std::pair<std::size_t, std::size_t> > files;
+            std::vector<char> same;
+            std::vector<group> rest;
+            
+            for(std::size_t g{0}; g < groups.size(); ++g)
+            {
+                for(std::size_t f{1}; f < groups[g].files.size(); ++f) files.emplace_back(g, f);
+            }
+            same.resize(files.size());
+            run_parallel(files.size(), threads, [&](const std::size_t& x)
+            {
+                same[x] = same_contents(groups[files[x].first].files.front(), groups[files[x].first].files[files[x].second]);
+            });
+            
+            for(std::size_t x{0}; x < files.size();)
+            {
+                const std::size_t g{files[x].first};
+                std::vector<path> matched{groups[g].files.front()}, unmatched;
+                
+                for(; (x < files.size()) && (files[x].first == g); ++x)
+                {
+                    (same[x] ? matched : unmatched).push_back(std::move(groups[g].files[files[x].second]));
+                }
+                if(matched.size() > 1) confirmed.push_back(group{groups[g].size, std::move(matched)});
+                if(unmatched.size() > 1) rest.push_back(group{groups[g].size, std::move(unmatched)});
+            }
+            groups = std::move(rest);
+        }
+        
+        std::vector<std::uint64_t> wasted;
+        for(group& c : confirmed)
+        {
+            std::sort(c.files.begin(), c.files.end());
+            wasted.push_back(c.size * (c.files.size() - 1));
+            duplicates.push_back(std::move(c.files));
+        }
+        
+        //most space to reclaim first:
+        std::vector<std::size_t> order(duplicates.size());
+        std::vector<std::vector<path> > sorted;
+        for(std::size_t x{0}; x < order.size(); ++x) order[x] = x;
+        std::stable_sort(order.begin(), order.end(), [&wasted](const std::size_t& a, const std::size_t& b){ return (wasted[a] > wasted[b]); });
+        for(const std::size_t& x : order) sorted.push_back(std::move(duplicates[x]));
+        return sorted;
+    }
+    
     
 }
 
@@ -107,7 +620,7 @@ namespace filesystem
     }
     
     regular_iterator::regular_iterator(const path& s) : 
-            beg_path(s),
+            beg_path(std::make_shared<const path>(s)),
             it(s)
     {
     }
@@ -118,6 +631,12 @@ namespace filesystem
     {
     }
     
+    regular_iterator::regular_iterator(regular_iterator&& i) noexcept : 
+            beg_path(std::move(i.beg_path)),
+            it(std::move(i.it))
+    {
+    }
+    
     regular_iterator::~regular_iterator()
     {
     }
@@ -132,6 +651,16 @@ namespace filesystem
         return *this;
     }
     
+    regular_iterator& regular_iterator::operator=(regular_iterator&& i) noexcept
+    {
+        if(this != &i)
+        {
+            this->it = std::move(i.it);
+            this->beg_path = std::move(i.beg_path);
+        }
+        return *this;
+    }
+    
     bool regular_iterator::operator!=(const regular_iterator& i) const
     {
         return (this->it != i.it);
@@ -154,16 +683,12 @@ namespace filesystem
     
     void regular_iterator::swap(regular_iterator& i)
     {
-        regular_iterator tempit(i);
-        i = (*this);
-        (*this) = tempit;
+        std::swap(this->beg_path, i.beg_path);
+        std::swap(this->it, i.it);
     }
     
     regular_iterator& regular_iterator::operator++()
     {
-        using boost::filesystem::is_directory;
-        using boost::filesystem::is_symlink;
-        
         if(this->end()) return *this;
         ++(this->it);
         return *this;
@@ -192,19 +717,40 @@ namespace filesystem
 {
     recursive_iterator::recursive_iterator() : 
             it(),
-            beg_path()
+            beg_path(),
+            limits()
     {
     }
     
     recursive_iterator::recursive_iterator(const boost::filesystem::path& s) : 
             it(s),
-            beg_path(s)
+            beg_path(std::make_shared<const path>(s)),
+            limits()
+    {
+    }
+    
+    /**
+     * @brief Constructs an iterator that skips what's pruned by p.
+     */
+    recursive_iterator::recursive_iterator(const boost::filesystem::path& s, const prune& p) : 
+            it(s),
+            beg_path(std::make_shared<const path>(s)),
+            limits(std::make_shared<const prune>(p))
     {
+        this->skip_pruned();
     }
     
     recursive_iterator::recursive_iterator(const recursive_iterator& r) : 
             it(r.it),
-            beg_path(r.beg_path)
+            beg_path(r.beg_path),
+            limits(r.limits)
+    {
+    }
+    
+    recursive_iterator::recursive_iterator(recursive_iterator&& r) noexcept : 
+            it(std::move(r.it)),
+            beg_path(std::move(r.beg_path)),
+            limits(std::move(r.limits))
     {
     }
     
@@ -218,6 +764,18 @@ namespace filesystem
         {
             this->it = r.it;
             this->beg_path = r.beg_path;
+            this->limits = r.limits;
+        }
+        return *this;
+    }
+    
+    recursive_iterator& recursive_iterator::operator=(recursive_iterator&& r) noexcept
+    {
+        if(this != &r)
+        {
+            this->it = std::move(r.it);
+            this->beg_path = std::move(r.beg_path);
+            this->limits = std::move(r.limits);
         }
         return *this;
     }
@@ -244,21 +802,28 @@ namespace filesystem
     
     void recursive_iterator::swap(recursive_iterator& i)
     {
-        recursive_iterator tempit(i);
-        i = (*this);
-        (*this) = tempit;
+        std::swap(this->it, i.it);
+        std::swap(this->beg_path, i.beg_path);
+        std::swap(this->limits, i.limits);
     }
     
+    /**
+     * @brief Moves to the next entry, without following symlinks to folders.
+     * The entry's type is the one cached by the directory_entry (read from the
+     * folder itself where the filesystem records it), so this doesn't stat
+     * anything.  Callers should do the same, with it->status() and
+     * it->symlink_status(), rather than passing the path to is_directory etc.
+     */
     recursive_iterator& recursive_iterator::operator++()
     {
-        using boost::filesystem::is_directory;
         using boost::filesystem::is_symlink;
         
         if(this->end()) return *this;
         
         try
         {
-            if(is_directory(this->it->path()) && is_symlink(this->it->path()))
+            if(is_symlink(this->it->symlink_status()) || 
+                    (this->limits && (this->limits->max_depth >= 0) && (this->it.depth() >= this->limits->max_depth)))
             {
                 this->it.no_push();
             }
@@ -269,9 +834,59 @@ namespace filesystem
             this->it.no_push();
             ++(this->it);
         }
+        this->skip_pruned();
         return *this;
     }
     
+    /**
+     * @brief Moves past pruned entries, without entering pruned folders.
+     */
+    void recursive_iterator::skip_pruned()
+    {
+        while(this->limits && !this->end() && this->pruned())
+        {
+            try
+            {
+                this->it.no_push();
+                ++(this->it);
+            }
+            catch(...)
+            {
+                this->it.no_push();
+                ++(this->it);
+            }
+        }
+    }
+    
+    bool recursive_iterator::pruned()
+    {
+        using boost::filesystem::is_directory;
+        using boost::filesystem::is_regular_file;
+        
+        const prune& p(*(this->limits));
+        boost::system::error_code error;
+        
+        if(is_directory(this->it->symlink_status()))
+        {
+            for(const pattern& folder : p.folders)
+            {
+                if(folder.matches(this->it->path(), *(this->beg_path))) return true;
+            }
+            return (p.skip_folder && p.skip_folder(*(this->it)));
+        }
+        if(((p.min_size > 0) || (p.max_size < std::numeric_limits<std::uintmax_t>::max())) && is_regular_file(this->it->symlink_status()))
+        {
+            std::uintmax_t size{boost::filesystem::file_size(this->it->path(), error)};
+            if(!error && ((size < p.min_size) || (size > p.max_size))) return true;
+        }
+        if((p.modified_after > 0) && is_regular_file(this->it->symlink_status()))
+        {
+            std::time_t modified{boost::filesystem::last_write_time(this->it->path(), error)};
+            if(!error && (modified <= p.modified_after)) return true;
+        }
+        return false;
+    }
+    
     recursive_iterator recursive_iterator::operator++(int)
     {
         recursive_iterator newit(*this);
@@ -317,6 +932,13 @@ namespace filesystem
     {
     }
     
+    copy_iterator::copy_iterator(copy_iterator&& c) noexcept : 
+            recursive_iterator(std::move(c)),
+            source(std::move(c.source)),
+            dest(std::move(c.dest))
+    {
+    }
+    
     copy_iterator::~copy_iterator()
     {
     }
@@ -332,6 +954,17 @@ namespace filesystem
         return *this;
     }
     
+    copy_iterator& copy_iterator::operator=(copy_iterator&& c) noexcept
+    {
+        if(this != &c)
+        {
+            recursive_iterator::operator=(std::move(c));
+            this->source = std::move(c.source);
+            this->dest = std::move(c.dest);
+        }
+        return *this;
+    }
+    
     copy_iterator& copy_iterator::operator++()
     {
         copy_path(this->source, this->it->path(), this->dest);
@@ -346,51 +979,312 @@ namespace filesystem
         return newit;
     }
     
+    void copy_iterator::swap(copy_iterator& c)
+    {
+        recursive_iterator::swap(c);
+        std::swap(this->source, c.source);
+        std::swap(this->dest, c.dest);
+    }
+    
     
 }
 
-//glob member functions:
+/* pattern member functions: */
 namespace filesystem
 {
-    glob::glob() : 
-            regular_iterator(),
-            expression(),
-            exact_match(false)
+    pattern::pattern() : 
+            source(),
+            prefix(),
+            suffix(),
+            tokens(),
+            how(strategy::literal),
+            whole_path(false)
     {
     }
     
-    glob::glob(const glob& g) : 
-            regular_iterator(g),
-            expression(g.expression),
-            exact_match(g.exact_match)
+    /**
+     * @brief Compiles a glob pattern.  Throws a runtime_error if it has too many
+     * parts to be matched by the automaton (more than 62 characters and wildcards).
+     */
+    pattern::pattern(const std::string& s) : 
+            source(s),
+            prefix(),
+            suffix(),
+            tokens(),
+            how(strategy::automaton),
+            whole_path(s.find('/') != std::string::npos)
     {
+        std::size_t stars{0}, star{0}, others{0};
+        
+        for(std::size_t x{0}; x < s.size(); ++x)
+        {
+            token t{token_type::character, s[x], {}};
+            
+            if((s[x] == '\\') && ((x + 1) < s.size())) t.c = s[++x];
+            else if(s[x] == '?') t.type = token_type::any_character;
+            else if(s[x] == '*')
+            {
+                if(((x + 1) < s.size()) && (s[x + 1] == '*'))
+                {
+                    while(((x + 1) < s.size()) && (s[x + 1] == '*')) ++x;
+                    if(((x + 1) < s.size()) && (s[x + 1] == '/'))
+                    {
+                        ++x;
+                        this->tokens.push_back(token{token_type::folders, 0, {}});
+                        t.type = token_type::folders_inside;
+                    }
+                    else t.type = token_type::any_path;
+                }
+                else t.type = token_type::any;
+            }
+            else if(s[x] == '[')
+            {
+                //find the closing bracket; a ']' right after the opening one is part of the set:
+                std::size_t first{x + 1}, end;
+                bool negate{(first < s.size()) && ((s[first] == '!') || (s[first] == '^'))};
+                
+                if(negate) ++first;
+                end = s.find(']', (first + 1));
+                if((first < s.size()) && (end != std::string::npos))
+                {
+                    t.type = token_type::any_of;
+                    for(std::size_t y{first}; y < end; ++y)
+                    {
+                        if(((y + 2) < end) && (s[y + 1] == '-'))
+                        {
+                            for(int c{static_cast<unsigned char>(s[y])}; c <= static_cast<unsigned char>(s[y + 2]); ++c) t.set.set(c);
+                            y += 2;
+                        }
+                        else t.set.set(static_cast<unsigned char>(s[y]));
+                    }
+                    if(negate) t.set.flip();
+                    x = end;
+                }
+            }
+            
+            if((t.type == token_type::any) || (t.type == token_type::any_path))
+            {
+                ++stars;
+                star = this->tokens.size();
+            }
+            else if(t.type != token_type::character) ++others;
+            this->tokens.push_back(t);
+        }
+        
+        //literal and prefix*suffix patterns are just compared:
+        if((others == 0) && (stars <= 1))
+        {
+            this->how = ((stars == 0) ? strategy::literal : strategy::affixes);
+            if(stars == 0) star = this->tokens.size();
+            for(std::size_t x{0}; x < star; ++x) this->prefix += this->tokens[x].c;
+            for(std::size_t x{star + 1}; x < this->tokens.size(); ++x) this->suffix += this->tokens[x].c;
+            if((stars == 0) || (this->tokens[star].type == token_type::any_path)) this->tokens.erase(this->tokens.begin(), this->tokens.end());
+            else this->tokens.assign(1, this->tokens[star]);
+        }
+        else if(this->tokens.size() > 62) throw std::runtime_error{"Error: glob pattern \"" + s + "\" is too long"};
     }
     
     /**
-     * @brief Constructs a glob iterator.
-     * @param p The folder.
-     * @param r Te regex to match the path against.
-     * @param e If true, matches the patch exactly with the regex.
+     * @brief Matches a name, or a relative path if the pattern has a '/'.
      */
-    glob::glob(const boost::filesystem::path& p, const std::string& r, const bool& e) : 
-            regular_iterator(p),
-            expression(r, boost::regex::basic),
-            exact_match(e)
+    bool pattern::matches(const char* s, const std::size_t& size) const
     {
-        if(!this->matches()) this->operator++();
+        switch(this->how)
+        {
+            case strategy::literal:
+                return ((size == this->prefix.size()) && (std::memcmp(s, this->prefix.data(), size) == 0));
+                
+            case strategy::affixes:
+            {
+                const std::size_t middle{size - this->prefix.size() - this->suffix.size()};
+                
+                if(size < (this->prefix.size() + this->suffix.size())) return false;
+                if(std::memcmp(s, this->prefix.data(), this->prefix.size()) != 0) return false;
+                if(std::memcmp((s + size - this->suffix.size()), this->suffix.data(), this->suffix.size()) != 0) return false;
+                
+                //a single '*' can't match a '/':
+                return (this->tokens.empty() || (std::memchr((s + this->prefix.size()), '/', middle) == nullptr));
+            }
+            
+            default:
+                return this->simulate(s, size);
+        }
     }
     
-    glob::~glob()
+    bool pattern::matches(const std::string& s) const
     {
+        return this->matches(s.data(), s.size());
     }
     
-    glob& glob::operator=(const glob& g)
+    /**
+     * @brief Matches an entry found within root:  its name, or its path relative
+     * to root if the pattern has a '/'.
+     */
+    bool pattern::matches(const boost::filesystem::path& p, const boost::filesystem::path& root) const
     {
-        if(this != &g)
+        const std::string& s(p.string()); //a reference to the path itself on POSIX, so no copy is made
+        std::size_t start{0};
+        
+        if(!this->whole_path)
+        {
+            std::string::size_type separator{s.rfind('/')};
+            if(separator != std::string::npos) start = (separator + 1);
+        }
+        else
+        {
+            const std::string& r(root.string());
+            if(s.compare(0, r.size(), r) == 0)
+            {
+                start = r.size();
+                if((start < s.size()) && (s[start] == '/')) ++start;
+            }
+        }
+        return this->matches((s.data() + start), (s.size() - start));
+    }
+    
+    bool pattern::empty() const
+    {
+        return this->source.empty();
+    }
+    
+    const std::string& pattern::str() const
+    {
+        return this->source;
+    }
+    
+    /**
+     * @brief Runs the pattern's automaton over s.  Each token is a state, and the
+     * set of states that are active is kept as the bits of one integer, so every
+     * possible way of matching is tried at once without backtracking.
+     */
+    bool pattern::simulate(const char* s, const std::size_t& size) const
+    {
+        const std::size_t end{this->tokens.size()};
+        
+        //wildcards that can match nothing let the states after them start right away:
+        auto closure = [this, &end](std::uint64_t states)
+        {
+            for(std::size_t x{0}; x < end; ++x)
+            {
+                if(((states >> x) & 1) == 0) continue;
+                if((this->tokens[x].type == token_type::any) || (this->tokens[x].type == token_type::any_path)) states |= (std::uint64_t{1} << (x + 1));
+                else if(this->tokens[x].type == token_type::folders) states |= (std::uint64_t{1} << (x + 2));
+            }
+            return states;
+        };
+        
+        std::uint64_t states{closure(1)};
+        
+        for(std::size_t y{0}; (y < size) && (states != 0); ++y)
+        {
+            const char c{s[y]};
+            std::uint64_t next{0};
+            
+            for(std::size_t x{0}; x < end; ++x)
+            {
+                const token& t(this->tokens[x]);
+                const std::uint64_t here{std::uint64_t{1} << x}, after{here << 1};
+                
+                if((states & here) == 0) continue;
+                switch(t.type)
+                {
+                    case token_type::character: if(c == t.c) next |= after; break;
+                    case token_type::any_character: if(c != '/') next |= after; break;
+                    case token_type::any_of: if((c != '/') && t.set.test(static_cast<unsigned char>(c))) next |= after; break;
+                    case token_type::any: if(c != '/') next |= here; break;
+                    case token_type::any_path: next |= here; break;
+                    case token_type::folders: next |= ((c == '/') ? (after | (after << 1)) : after); break;
+                    case token_type::folders_inside: next |= ((c == '/') ? (here | after) : here); break;
+                }
+            }
+            states = closure(next);
+        }
+        return (((states >> end) & 1) != 0);
+    }
+    
+    
+}
+
+//glob member functions:
+namespace filesystem
+{
+    glob::glob() : 
+            regular_iterator(),
+            expression(),
+            exact_match(false),
+            compiled()
+    {
+    }
+    
+    glob::glob(const glob& g) : 
+            regular_iterator(g),
+            expression(g.expression),
+            exact_match(g.exact_match),
+            compiled(g.compiled)
+    {
+    }
+    
+    glob::glob(glob&& g) noexcept : 
+            regular_iterator(std::move(g)),
+            expression(std::move(g.expression)),
+            exact_match(g.exact_match),
+            compiled(std::move(g.compiled))
+    {
+    }
+    
+    /**
+     * @brief Constructs a glob iterator.
+     * @param p The folder.
+     * @param r Te regex to match the path against.
+     * @param e If true, matches the patch exactly with the regex.
+     */
+    glob::glob(const boost::filesystem::path& p, const std::string& r, const bool& e) : 
+            regular_iterator(p),
+            expression(std::make_shared<const boost::regex>(r, boost::regex::basic)),
+            exact_match(e),
+            compiled()
+    {
+        if(!this->matches()) this->operator++();
+    }
+    
+    /**
+     * @brief Constructs a glob iterator that matches a glob pattern.
+     * @param p The folder.
+     * @param g The pattern.
+     */
+    glob::glob(const boost::filesystem::path& p, const pattern& g) : 
+            regular_iterator(p),
+            expression(),
+            exact_match(false),
+            compiled(std::make_shared<const pattern>(g))
+    {
+        if(!this->matches()) this->operator++();
+    }
+    
+    glob::~glob()
+    {
+    }
+    
+    glob& glob::operator=(const glob& g)
+    {
+        if(this != &g)
         {
             regular_iterator::operator=(g);
             this->expression = g.expression;
             this->exact_match = g.exact_match;
+            this->compiled = g.compiled;
+        }
+        return *this;
+    }
+    
+    glob& glob::operator=(glob&& g) noexcept
+    {
+        if(this != &g)
+        {
+            regular_iterator::operator=(std::move(g));
+            this->expression = std::move(g.expression);
+            this->exact_match = g.exact_match;
+            this->compiled = std::move(g.compiled);
         }
         return *this;
     }
@@ -412,18 +1306,27 @@ namespace filesystem
         return tempg;
     }
     
+    void glob::swap(glob& g)
+    {
+        regular_iterator::swap(g);
+        std::swap(this->expression, g.expression);
+        std::swap(this->exact_match, g.exact_match);
+        std::swap(this->compiled, g.compiled);
+    }
+    
     bool glob::matches() const
     {
         using boost::regex_match;
         using boost::regex_search;
         
         if(this->end()) return false;
+        if(this->compiled) return this->compiled->matches(this->it->path(), *(this->beg_path));
         
         if(this->exact_match)
         {
-            return regex_match(this->it->path().string().c_str(), this->expression);
+            return regex_match(this->it->path().string().c_str(), *(this->expression));
         }
-        return regex_search(this->it->path().string().c_str(), this->expression);
+        return regex_search(this->it->path().string().c_str(), *(this->expression));
     }
     
     
@@ -435,21 +1338,62 @@ namespace filesystem
     recursive_glob::recursive_glob() : 
             recursive_iterator(),
             expression(),
-            exact_match(false)
+            exact_match(false),
+            compiled()
     {
     }
     
     recursive_glob::recursive_glob(const recursive_glob& g) : 
             recursive_iterator(g),
             expression(g.expression),
-            exact_match(g.exact_match)
+            exact_match(g.exact_match),
+            compiled(g.compiled)
+    {
+    }
+    
+    recursive_glob::recursive_glob(recursive_glob&& g) noexcept : 
+            recursive_iterator(std::move(g)),
+            expression(std::move(g.expression)),
+            exact_match(g.exact_match),
+            compiled(std::move(g.compiled))
     {
     }
     
     recursive_glob::recursive_glob(const boost::filesystem::path& p, const std::string& r, const bool& e) : 
             recursive_iterator(p),
-            expression(r, boost::regex::basic),
-            exact_match(e)
+            expression(std::make_shared<const boost::regex>(r, boost::regex::basic)),
+            exact_match(e),
+            compiled()
+    {
+        if(!this->matches()) this->operator++();
+    }
+    
+    /**
+     * @brief Constructs a recursive_glob iterator that matches a glob pattern.
+     * @param p The folder.
+     * @param g The pattern.
+     */
+    recursive_glob::recursive_glob(const boost::filesystem::path& p, const pattern& g) : 
+            recursive_iterator(p),
+            expression(),
+            exact_match(false),
+            compiled(std::make_shared<const pattern>(g))
+    {
+        if(!this->matches()) this->operator++();
+    }
+    
+    /**
+     * @brief Constructs a recursive_glob iterator that matches a glob pattern,
+     * and doesn't go where l prunes.
+     * @param p The folder.
+     * @param g The pattern.
+     * @param l What to prune.
+     */
+    recursive_glob::recursive_glob(const boost::filesystem::path& p, const pattern& g, const prune& l) : 
+            recursive_iterator(p, l),
+            expression(),
+            exact_match(false),
+            compiled(std::make_shared<const pattern>(g))
     {
         if(!this->matches()) this->operator++();
     }
@@ -465,6 +1409,19 @@ namespace filesystem
             recursive_iterator::operator=(r);
             this->expression = r.expression;
             this->exact_match = r.exact_match;
+            this->compiled = r.compiled;
+        }
+        return *this;
+    }
+    
+    recursive_glob& recursive_glob::operator=(recursive_glob&& r) noexcept
+    {
+        if(this != &r)
+        {
+            recursive_iterator::operator=(std::move(r));
+            this->expression = std::move(r.expression);
+            this->exact_match = r.exact_match;
+            this->compiled = std::move(r.compiled);
         }
         return *this;
     }
@@ -486,20 +1443,990 @@ namespace filesystem
         return tempg;
     }
     
+    void recursive_glob::swap(recursive_glob& g)
+    {
+        recursive_iterator::swap(g);
+        std::swap(this->expression, g.expression);
+        std::swap(this->exact_match, g.exact_match);
+        std::swap(this->compiled, g.compiled);
+    }
+    
     bool recursive_glob::matches() const
     {
         using boost::regex_match;
         using boost::regex_search;
         
         if(this->end()) return false;
+        if(this->compiled) return this->compiled->matches(this->it->path(), *(this->beg_path));
         
         if(this->exact_match)
         {
-            return regex_match(this->it->path().string().c_str(), this->expression);
+            return regex_match(this->it->path().string().c_str(), *(this->expression));
+        }
+        return regex_search(this->it->path().string().c_str(), *(this->expression));
+    }
+    
+    
+}
+
+
+/* parallel_walk: */
+namespace filesystem
+{
+    /**
+     * @brief Walks a folder recursively, reading its subfolders concurrently on
+     * several threads, and calls f for every entry found.  f is called from
+     * those threads, so it must be safe to call concurrently.  Returns once
+     * every folder has been read.
+     * @param root The folder to walk.
+     * @param f Called with each entry.  For folders, its return value is
+     * whether to walk them too.
+     * @param threads How many threads to read with.  0 picks a number based on
+     * the hardware; more threads than cores helps when reads wait on the disk.
+     * 
+     * Folders that can't be read are skipped, except for root, which throws
+     * a runtime_error.  If f throws, the walk stops, and the exception is
+     * rethrown.
+     */
+    void parallel_walk(const path& root, const std::function<bool(const walk_entry&)>& f, const unsigned int& threads)
+    {
+        struct folder
+        {
+            path p;
+            unsigned int depth;
+        };
+        
+        std::mutex m;
+        std::condition_variable ready;
+        std::deque<folder> queue{folder{root, 0}};
+        std::size_t pending{1}; //folders queued or being read
+        std::exception_ptr error;
+        std::vector<std::thread> workers;
+        bool root_failed{false};
+        
+        auto work = [&]()
+        {
+            std::vector<folder> found;
+            
+            while(true)
+            {
+                folder current;
+                {
+                    std::unique_lock<std::mutex> lock{m};
+                    ready.wait(lock, [&](){ return (!queue.empty() || (pending == 0)); });
+                    if(queue.empty()) return;
+                    current = std::move(queue.front());
+                    queue.pop_front();
+                }
+                
+                found.clear();
+                try
+                {
+                    bool read{read_directory(current.p, [&](const char* name, const boost::filesystem::file_type& type, const std::uint64_t& inode)
+                    {
+                        walk_entry e{(current.p / name), type, inode, current.depth};
+                        if(f(e) && (type == boost::filesystem::directory_file)) found.push_back(folder{std::move(e.path), (current.depth + 1)});
+                    })};
+                    if(!read && (current.depth == 0)) root_failed = true;
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock{m};
+                    if(!error) error = std::current_exception();
+                    pending -= (queue.size() + 1);
+                    queue.clear();
+                    ready.notify_all();
+                    continue;
+                }
+                
+                bool done;
+                {
+                    std::lock_guard<std::mutex> lock{m};
+                    if(!error)
+                    {
+                        for(folder& sub : found) queue.push_back(std::move(sub));
+                        pending += found.size();
+                    }
+                    done = (--pending == 0);
+                }
+                if(done || (found.size() > 1)) ready.notify_all();
+                else if(!found.empty()) ready.notify_one();
+            }
+        };
+        
+        for(unsigned int x{0}; x < ((threads > 0) ? threads : std::max(4u, (2 * std::thread::hardware_concurrency()))); ++x) workers.emplace_back(work);
+        for(std::thread& t : workers) t.join();
+        
+        if(error) std::rethrow_exception(error);
+        if(root_failed) throw std::runtime_error{"Error: unable to read folder \"" + root.string() + "\""};
+    }
+    
+    
+}
+
+/* parallel_copy: */
+namespace filesystem
+{
+    /**
+     * @brief Recursively copies a folder into another folder, like copy_iterator.
+     * The tree is read first (with parallel_walk), every folder is created, and
+     * then the files are copied concurrently.
+     * @param from The folder to copy.
+     * @param to The folder to copy it into.  from is copied to to / from.filename(),
+     * which must not exist.
+     * @param progress If given, called on the calling thread about 10 times per
+     * second while files are copied, and once when they're done.
+     * @param threads How many files to copy at once.  0 picks a number based on the
+     * hardware.
+     * 
+     * Symlinks are copied as symlinks.  If a file can't be copied, the copy
+     * stops, and the error is thrown.  Throws a filesystem_error if from isn't a
+     * folder.
+     */
+    void parallel_copy(const path& from, const path& to, const std::function<void(const copy_progress&)>& progress, const unsigned int& threads)
+    {
+        using boost::filesystem::is_directory;
+        using boost::filesystem::filesystem_error;
+        using clock = std::chrono::steady_clock;
+        
+        struct file
+        {
+            path relative;
+            std::uint64_t size;
+        };
+        
+        const path dest{to / from.filename()};
+        std::mutex m;
+        std::vector<path> folders, links;
+        std::vector<file> files;
+        std::atomic<std::uint64_t> bytes{0}, bytes_total{0};
+        std::atomic<std::size_t> next{0}, done{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::vector<std::thread> workers;
+        const clock::time_point start{clock::now()};
+        
+        if(from.empty() || !is_directory(from)) throw filesystem_error("Not a folder!", from, to, boost::system::errc::make_error_code(boost::system::errc::not_a_directory));
+        if(is_directory(dest)) throw filesystem_error("Path exists!", from, to, boost::system::error_code{});
+        
+        //read the tree:
+        const std::size_t root_size{from.string().size() + ((from.string().back() == '/') ? 0 : 1)};
+        parallel_walk(from, [&](const walk_entry& e)
+        {
+            path relative{e.path.string().substr(root_size)};
+            std::uint64_t size{0};
+            
+            if(e.type == boost::filesystem::regular_file)
+            {
+                boost::system::error_code ec;
+                size = boost::filesystem::file_size(e.path, ec);
+            }
+            std::lock_guard<std::mutex> lock{m};
+            if(e.type == boost::filesystem::directory_file) folders.push_back(std::move(relative));
+            else if(e.type == boost::filesystem::symlink_file) links.push_back(std::move(relative));
+            else if(e.type == boost::filesystem::regular_file)
+            {
+                files.push_back(file{std::move(relative), size});
+                bytes_total += size;
+            }
+            return true;
+        }, threads);
+        
+        //build the skeleton, parents first:
+        std::sort(folders.begin(), folders.end());
+        boost::filesystem::copy_directory(from, dest);
+        for(const path& folder : folders) boost::filesystem::copy_directory((from / folder), (dest / folder));
+        for(const path& link : links) boost::filesystem::copy_symlink((from / link), (dest / link));
+        
+        //the biggest files first, so that one isn't left copying alone at the end:
+        std::sort(files.begin(), files.end(), [](const file& a, const file& b){ return (a.size > b.size); });
+        
+        auto work = [&]()
+        {
+            for(std::size_t x{next++}; (x < files.size()) && !failed; x = next++)
+            {
+                try
+                {
+                    copy_contents((from / files[x].relative), (dest / files[x].relative), bytes);
+                    ++done;
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock{m};
+                    if(!error) error = std::current_exception();
+                    failed = true;
+                }
+            }
+        };
+        
+        auto report = [&]()
+        {
+            if(!progress) return;
+            
+            copy_progress p{done, files.size(), bytes, bytes_total, std::chrono::duration<double>(clock::now() - start).count(), 0};
+            if(p.seconds > 0) p.bytes_per_second = (p.bytes / p.seconds);
+            progress(p);
+        };
+        
+        for(unsigned int x{0}; x < std::max(1u, std::min<unsigned int>(((threads > 0) ? threads : std::max(4u, std::thread::hardware_concurrency())), files.size())); ++x)
+        {
+            workers.emplace_back(work);
+        }
+        while(progress && (done < files.size()) && !failed)
+        {
+            report();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        for(std::thread& t : workers) t.join();
+        
+        if(error) std::rethrow_exception(error);
+        report();
+    }
+    
+    
+}
+
+/* find_duplicates: */
+namespace filesystem
+{
+    /**
+     * @brief Finds the files in a folder, and all of its subfolders, that have
+     * identical contents.  Files are only read when other files have the same
+     * size, and are only read entirely when their first 4 KiB match too.
+     * @param root The folder to search.
+     * @param threads How many threads to read with.  0 picks a number based on
+     * the hardware.
+     * @return Each set of identical files, sorted, with the sets that waste the
+     * most space first.  Empty files are left out, and so are extra hard links
+     * to a file, since removing those doesn't reclaim anything.
+     */
+    std::vector<std::vector<path> > find_duplicates(const path& root, const unsigned int& threads)
+    {
+        return duplicates_in(recursive_iterator{root}, threads);
+    }
+    
+    /**
+     * @brief Finds the files with identical contents, skipping what p prunes.
+     */
+    std::vector<std::vector<path> > find_duplicates(const path& root, const prune& p, const unsigned int& threads)
+    {
+        return duplicates_in(recursive_iterator{root, p}, threads);
+    }
+    
+    
+}
+
+/* tree_snapshot member functions: */
+namespace filesystem
+{
+    tree_snapshot::tree_snapshot() : 
+            folder(),
+            hash(false),
+            taken(0),
+            all()
+    {
+    }
+    
+    /**
+     * @brief Takes a snapshot of a folder.  Throws a runtime_error if the folder
+     * doesn't exist.
+     * @param root The folder.
+     * @param h Whether to record a checksum of each file's contents.  Every file
+     * is read, so this is much slower.
+     */
+    tree_snapshot::tree_snapshot(const path& root, const bool& h) : 
+            folder(root),
+            hash(h),
+            taken(0),
+            all()
+    {
+        this->scan(nullptr);
+    }
+    
+    /**
+     * @brief Takes a new snapshot of the same folder, reusing this one's record
+     * of whatever hasn't changed since.
+     */
+    tree_snapshot tree_snapshot::rescan() const
+    {
+        tree_snapshot s;
+        
+        s.folder = this->folder;
+        s.hash = this->hash;
+        s.scan(this);
+        return s;
+    }
+    
+    /**
+     * @brief Compares this snapshot to a newer one.
+     * @return What was added, removed and changed since this snapshot.
+     */
+    tree_diff tree_snapshot::diff(const tree_snapshot& newer) const
+    {
+        tree_diff d;
+        auto a = this->all.begin();
+        auto b = newer.all.begin();
+        
+        while((a != this->all.end()) || (b != newer.all.end()))
+        {
+            if((b == newer.all.end()) || ((a != this->all.end()) && (a->first < b->first))) d.removed.push_back((a++)->first);
+            else if((a == this->all.end()) || (b->first < a->first)) d.added.push_back((b++)->first);
+            else
+            {
+                if(differs(a->second, b->second)) d.changed.push_back(a->first);
+                ++a;
+                ++b;
+            }
         }
-        return regex_search(this->it->path().string().c_str(), this->expression);
+        return d;
+    }
+    
+    const path& tree_snapshot::root() const
+    {
+        return this->folder;
+    }
+    
+    const std::map<std::string, tree_entry>& tree_snapshot::entries() const
+    {
+        return this->all;
+    }
+    
+    /**
+     * @brief Reads the tree.  If there's a previous snapshot, the entries of
+     * folders it recorded that haven't been modified since are taken from it
+     * instead of being read, and so are the checksums of unmodified files.
+     */
+    void tree_snapshot::scan(const tree_snapshot* previous)
+    {
+        using boost::filesystem::directory_file;
+        using boost::filesystem::regular_file;
+        
+        constexpr std::int64_t RACY{2000000000}; //modified this close to the previous snapshot, a change may not show
+        std::vector<std::string> folders{""};
+        
+        auto before = [previous](const std::string& relative) -> const tree_entry*
+        {
+            if(previous == nullptr) return nullptr;
+            
+            std::map<std::string, tree_entry>::const_iterator it{previous->all.find(relative)};
+            return ((it == previous->all.end()) ? nullptr : &(it->second));
+        };
+        auto unchanged = [previous](const tree_entry* b, const tree_entry& e)
+        {
+            return ((b != nullptr) && (b->type == e.type) && (b->inode == e.inode) && (b->size == e.size) && 
+                    (b->modified == e.modified) && (b->modified < (previous->taken - RACY)));
+        };
+        
+        this->taken = now();
+        this->all.clear();
+        if(!inspect(this->folder, this->all[""]) || (this->all[""].type != directory_file))
+        {
+            throw std::runtime_error{"Error: unable to read folder \"" + this->folder.string() + "\""};
+        }
+        
+        while(!folders.empty())
+        {
+            const std::string relative{std::move(folders.back())};
+            const path p{relative.empty() ? this->folder : (this->folder / relative)};
+            const tree_entry* b{before(relative)};
+            tree_entry& current(this->all[relative]);
+            std::vector<std::string> names;
+            
+            folders.pop_back();
+            if(unchanged(b, current)) names = b->names;
+            else
+            {
+                read_directory(p, [&names](const char* name, const boost::filesystem::file_type&, const std::uint64_t&){ names.emplace_back(name); });
+                std::sort(names.begin(), names.end());
+            }
+            
+            for(const std::string& name : names)
+            {
+                const std::string child{relative.empty() ? name : (relative + '/' + name)};
+                tree_entry e;
+                
+                if(!inspect((p / name), e)) continue; //removed since it was listed
+                current.names.push_back(name);
+                if(e.type == directory_file) folders.push_back(child);
+                else if(this->hash && (e.type == regular_file))
+                {
+                    const tree_entry* old{before(child)};
+                    if(unchanged(old, e) && old->hashed)
+                    {
+                        e.crc = old->crc;
+                        e.hashed = true;
+                    }
+                    else e.hashed = crc_of((p / name), e.crc);
+                }
+                this->all.emplace(child, std::move(e));
+            }
+        }
+    }
+    
+    /**
+     * @brief Writes a snapshot.  A folder's list of entries isn't written,
+     * since it can be rebuilt from the paths.
+     */
+    std::ostream& operator<<(std::ostream& out, const tree_snapshot& s)
+    {
+        using utility::out_mem;
+        using utility::write_string;
+        
+        write_string(out, "tree_snapshot 1");
+        write_string(out, s.folder.string());
+        out_mem<std::uint8_t>(out, s.hash);
+        out_mem<std::int64_t>(out, s.taken);
+        out_mem<std::uint64_t>(out, s.all.size());
+        for(const std::pair<const std::string, tree_entry>& e : s.all)
+        {
+            write_string(out, e.first);
+            out_mem<std::uint8_t>(out, e.second.type);
+            out_mem<std::uint64_t>(out, e.second.inode);
+            out_mem<std::uint64_t>(out, e.second.size);
+            out_mem<std::int64_t>(out, e.second.modified);
+            out_mem<std::uint32_t>(out, e.second.crc);
+            out_mem<std::uint8_t>(out, e.second.hashed);
+        }
+        return out;
+    }
+    
+    /**
+     * @brief Reads a snapshot written by operator<<.  If it isn't one, the
+     * stream's failbit is set.
+     */
+    std::istream& operator>>(std::istream& in, tree_snapshot& s)
+    {
+        using utility::in_mem;
+        using utility::read_string;
+        
+        std::string header, folder;
+        std::uint8_t hash{0};
+        std::uint64_t count{0};
+        
+        s = tree_snapshot{};
+        read_string(in, header);
+        if(header != "tree_snapshot 1")
+        {
+            in.setstate(std::ios_base::failbit);
+            return in;
+        }
+        read_string(in, folder);
+        in_mem<std::uint8_t>(in, hash);
+        in_mem<std::int64_t>(in, s.taken);
+        in_mem<std::uint64_t>(in, count);
+        s.folder = folder;
+        s.hash = (hash != 0);
+        
+        for(std::uint64_t x{0}; ((x < count) && in.good()); ++x)
+        {
+            std::string relative;
+            std::uint8_t type{0}, hashed{0};
+            tree_entry e{};
+            
+            read_string(in, relative);
+            in_mem<std::uint8_t>(in, type);
+            in_mem<std::uint64_t>(in, e.inode);
+            in_mem<std::uint64_t>(in, e.size);
+            in_mem<std::int64_t>(in, e.modified);
+            in_mem<std::uint32_t>(in, e.crc);
+            in_mem<std::uint8_t>(in, hashed);
+            if(in.fail()) break;
+            e.type = static_cast<boost::filesystem::file_type>(type);
+            e.hashed = (hashed != 0);
+            s.all.emplace(std::move(relative), std::move(e));
+        }
+        
+        //paths are sorted, so each folder's entries are added in order:
+        for(const std::pair<const std::string, tree_entry>& e : s.all)
+        {
+            if(e.first.empty()) continue;
+            
+            std::string::size_type slash{e.first.rfind('/')};
+            std::map<std::string, tree_entry>::iterator parent{s.all.find((slash == std::string::npos) ? std::string{} : e.first.substr(0, slash))};
+            if(parent != s.all.end()) parent->second.names.push_back(e.first.substr((slash == std::string::npos) ? 0 : (slash + 1)));
+        }
+        return in;
     }
     
     
 }
 
+/* watch member functions: */
+namespace filesystem
+{
+    /**
+     * @brief Starts watching a folder, and waits for the first change.  Throws
+     * a runtime_error if the folder can't be watched.
+     * @param folder The folder.
+     * @param t How long to wait for a change before ending.  0 waits forever.
+     */
+    watch::watch(const path& folder, const std::chrono::milliseconds& t) : 
+            root(folder),
+            timeout(t),
+            fd(-1),
+            folders(),
+            queue(),
+            current(),
+            removed(false),
+            at_end(false)
+    {
+#ifdef __linux__
+        this->fd = ::inotify_init1(IN_CLOEXEC);
+        if(this->fd < 0) throw std::runtime_error{"Error: unable to initialize inotify"};
+        this->add(this->root, nullptr);
+        if(this->folders.empty())
+        {
+            ::close(this->fd);
+            throw std::runtime_error{"Error: unable to watch folder \"" + this->root.string() + "\""};
+        }
+        this->operator++();
+#else
+        throw std::runtime_error{"Error: filesystem::watch is only available on Linux"};
+#endif
+    }
+    
+    watch::~watch()
+    {
+#ifdef __linux__
+        if(this->fd >= 0) ::close(this->fd);
+#endif
+    }
+    
+    /**
+     * @brief Moves to the next change, waiting for one if there isn't one yet.
+     */
+    watch& watch::operator++()
+    {
+        if(this->queue.empty() && !this->removed) this->read((this->timeout.count() > 0) ? static_cast<int>(this->timeout.count()) : -1);
+        this->at_end = this->queue.empty();
+        if(!this->at_end)
+        {
+            this->current = std::move(this->queue.front());
+            this->queue.pop_front();
+        }
+        return *this;
+    }
+    
+    const watch_event& watch::operator*() const
+    {
+        return this->current;
+    }
+    
+    const watch_event* watch::operator->() const
+    {
+        return &(this->current);
+    }
+    
+    bool watch::end() const
+    {
+        return this->at_end;
+    }
+    
+    /**
+     * @brief Watches a folder and its subfolders.  The folder is watched before
+     * it's read, so nothing created in the meantime is missed.
+     * @param folder The folder.
+     * @param found If not null, called with every entry found in the folders.
+     */
+    void watch::add(const path& folder, const std::function<void(const path&, const bool&)>& found)
+    {
+#ifdef __linux__
+        constexpr std::uint32_t MASK{IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | 
+                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK};
+        std::vector<path> stack{folder};
+        
+        while(!stack.empty())
+        {
+            const path p{std::move(stack.back())};
+            int wd;
+            
+            stack.pop_back();
+            wd = ::inotify_add_watch(this->fd, p.c_str(), MASK);
+            if(wd < 0) continue;
+            this->folders[wd] = p;
+            read_directory(p, [&](const char* name, const boost::filesystem::file_type& type, const std::uint64_t&)
+            {
+                const bool is_folder{type == boost::filesystem::directory_file};
+                
+                if(found) found((p / name), is_folder);
+                if(is_folder) stack.push_back(p / name);
+            });
+        }
+#endif
+    }
+    
+    /**
+     * @brief Stops watching a folder that was moved out of the tree, and its
+     * subfolders.
+     */
+    void watch::forget(const path& folder)
+    {
+#ifdef __linux__
+        for(std::map<int, path>::iterator it{this->folders.begin()}; it != this->folders.end();)
+        {
+            if(is_within(it->second, folder))
+            {
+                ::inotify_rm_watch(this->fd, it->first);
+                it = this->folders.erase(it);
+            }
+            else ++it;
+        }
+#endif
+    }
+    
+    /**
+     * @brief Waits for changes, and queues them.  Once something changes, the
+     * changes that follow within 10 milliseconds of each other (up to 100
+     * milliseconds in all) are read too, and coalesced with it.
+     * @param wait How many milliseconds to wait for a change.  -1 waits forever.
+     */
+    void watch::read(const int& wait)
+    {
+#ifdef __linux__
+        using clock = std::chrono::steady_clock;
+        
+        std::vector<watch_event> batch;
+        std::vector<char> live; //false for events that were coalesced away
+        std::map<path, std::size_t> latest; //path -> its event in the batch
+        std::map<std::uint32_t, std::size_t> moves; //cookie -> the event of a move whose destination isn't known yet
+        alignas(struct inotify_event) char buffer[1 << 16];
+        struct pollfd ready{this->fd, POLLIN, 0};
+        clock::time_point start;
+        
+        auto add_event = [&](const watch_event& e)
+        {
+            batch.push_back(e);
+            live.push_back(true);
+        };
+        
+        auto merge = [&](const watch_change& change, const path& p, const bool& folder)
+        {
+            std::map<path, std::size_t>::iterator it{latest.find(p)};
+            if(it == latest.end())
+            {
+                latest[p] = batch.size();
+                add_event(watch_event{change, p, path{}, folder});
+                return;
+            }
+            
+            watch_event& before(batch[it->second]);
+            switch(change)
+            {
+                case watch_change::created:
+                    if(before.change == watch_change::removed) before.change = watch_change::modified; //replaced
+                    before.folder = folder;
+                    break;
+                    
+                case watch_change::modified:
+                    if(before.change == watch_change::removed)
+                    {
+                        it->second = batch.size();
+                        add_event(watch_event{change, p, path{}, folder});
+                    }
+                    break;
+                    
+                case watch_change::removed:
+                    if(before.change == watch_change::created)
+                    {
+                        live[it->second] = false;
+                        latest.erase(it);
+                    }
+                    else before.change = watch_change::removed;
+                    break;
+                    
+                default:
+                    break;
+            }
+        };
+        
+        auto found = [&merge](const path& p, const bool& folder){ merge(watch_change::created, p, folder); };
+        
+        while(::poll(&ready, 1, wait) < 0)
+        {
+            if(errno != EINTR) return;
+        }
+        if(!(ready.revents & POLLIN)) return;
+        
+        start = clock::now();
+        do
+        {
+            ssize_t size{::read(this->fd, buffer, sizeof(buffer))};
+            if(size <= 0) break;
+            
+            for(ssize_t offset{0}; offset < size;)
+            {
+                const struct inotify_event* e{reinterpret_cast<const struct inotify_event*>(buffer + offset)};
+                std::map<int, path>::iterator folder{this->folders.find(e->wd)};
+                
+                offset += (sizeof(struct inotify_event) + e->len);
+                if(e->mask & IN_Q_OVERFLOW)
+                {
+                    add_event(watch_event{watch_change::lost, this->root, path{}, true});
+                    continue;
+                }
+                if(folder == this->folders.end()) continue;
+                if(e->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+                {
+                    if(folder->second == this->root) this->removed = true;
+                    if(e->mask & IN_IGNORED) this->folders.erase(folder);
+                    continue;
+                }
+                if(e->len == 0) continue;
+                
+                const path p{folder->second / e->name};
+                const bool is_folder{(e->mask & IN_ISDIR) != 0};
+                
+                if(e->mask & IN_CREATE)
+                {
+                    merge(watch_change::created, p, is_folder);
+                    if(is_folder) this->add(p, found);
+                }
+                else if(e->mask & (IN_MODIFY | IN_CLOSE_WRITE)) merge(watch_change::modified, p, is_folder);
+                else if(e->mask & IN_DELETE) merge(watch_change::removed, p, is_folder);
+                else if(e->mask & IN_MOVED_FROM)
+                {
+                    moves[e->cookie] = batch.size();
+                    latest.erase(p);
+                    add_event(watch_event{watch_change::moved, p, p, is_folder});
+                }
+                else if(e->mask & IN_MOVED_TO)
+                {
+                    std::map<std::uint32_t, std::size_t>::iterator move{moves.find(e->cookie)};
+                    
+                    latest.erase(p);
+                    if(move == moves.end())
+                    {
+                        merge(watch_change::created, p, is_folder); //moved in from outside of the tree
+                        if(is_folder) this->add(p, found);
+                        continue;
+                    }
+                    
+                    watch_event& moved(batch[move->second]);
+                    moved.path = p;
+                    if(is_folder)
+                    {
+                        for(std::pair<const int, path>& f : this->folders)
+                        {
+                            if(is_within(f.second, moved.from)) f.second = (p.native() + f.second.native().substr(moved.from.native().size()));
+                        }
+                    }
+                    moves.erase(move);
+                }
+            }
+        }while((std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count() < 100) && (::poll(&ready, 1, 10) > 0));
+        
+        //moved out of the tree:
+        for(const std::pair<const std::uint32_t, std::size_t>& move : moves)
+        {
+            watch_event& e(batch[move.second]);
+            
+            e.change = watch_change::removed;
+            e.from.clear();
+            if(e.folder) this->forget(e.path);
+        }
+        
+        for(std::size_t x{0}; x < batch.size(); ++x)
+        {
+            if(live[x]) this->queue.push_back(std::move(batch[x]));
+        }
+#else
+        (void)wait;
+#endif
+    }
+    
+    
+}
+
+/* usage_cache member functions: */
+namespace filesystem
+{
+    /**
+     * @param t How long a tree is trusted before it's read entirely again.
+     * @param n How many threads to read with.  0 picks a number based on the
+     * hardware.
+     */
+    usage_cache::usage_cache(const std::chrono::milliseconds& t, const unsigned int& n) : 
+            ttl(t),
+            threads(n),
+            m(),
+            trees()
+    {
+    }
+    
+    /**
+     * @brief Measures a folder, and each of its subfolders.  Throws a
+     * runtime_error if the folder can't be read.
+     * @return The usage of each folder, including what's in its subfolders,
+     * by path relative to root.  The root's is "".
+     */
+    std::map<std::string, usage> usage_cache::folders(const path& root)
+    {
+        std::map<std::string, usage> totals;
+        std::lock_guard<std::mutex> lock{this->m};
+        tree& t(this->trees[root]);
+        
+        try
+        {
+            this->refresh(root, t);
+        }
+        catch(...)
+        {
+            this->trees.erase(root);
+            throw;
+        }
+        
+        //a folder's subfolders come after it, so they're added up before it is:
+        for(std::map<std::string, folder>::const_reverse_iterator f{t.folders.rbegin()}; f != t.folders.rend(); ++f)
+        {
+            usage& u(totals[f->first]);
+            
+            add_usage(u, f->second.own);
+            if(!f->first.empty()) add_usage(totals[parent_of(f->first)], u);
+        }
+        return totals;
+    }
+    
+    /**
+     * @return The usage of a folder, including its subfolders.
+     */
+    usage usage_cache::total(const path& root)
+    {
+        return this->folders(root)[""];
+    }
+    
+    /**
+     * @brief Drops what's cached about a folder.
+     */
+    void usage_cache::forget(const path& root)
+    {
+        std::lock_guard<std::mutex> lock{this->m};
+        this->trees.erase(root);
+    }
+    
+    /**
+     * @brief Brings a tree up to date.  It's read entirely if it never has
+     * been, or if it's older than the time to live.  Otherwise, every folder is
+     * stat'ed, folders that are gone are dropped, and folders that changed are
+     * read again, along with any new subfolders.
+     */
+    void usage_cache::refresh(const path& root, tree& t)
+    {
+        constexpr std::int64_t RACY{2000000000}; //modified this close to being read, a change may not show
+        constexpr char CHANGED{1}, GONE{2};
+        
+        std::vector<std::string> keys;
+        std::vector<char> state;
+        
+        if(t.folders.empty() || ((std::chrono::steady_clock::now() - t.read) >= this->ttl))
+        {
+            t.read = std::chrono::steady_clock::now();
+            this->scan(root, "", t);
+            return;
+        }
+        
+        keys.reserve(t.folders.size());
+        for(const std::pair<const std::string, folder>& f : t.folders) keys.push_back(f.first);
+        state.resize(keys.size(), 0);
+        run_parallel(keys.size(), this->threads, [&](const std::size_t& x)
+        {
+            const folder& f(t.folders.find(keys[x])->second);
+            tree_entry e;
+            
+            if(!inspect((keys[x].empty() ? root : (root / keys[x])), e) || (e.type != boost::filesystem::directory_file)) state[x] = GONE;
+            else if((e.inode != f.inode) || (e.modified != f.modified) || (f.modified >= (f.read - RACY))) state[x] = CHANGED;
+        });
+        
+        for(std::size_t x{0}; x < keys.size(); ++x)
+        {
+            if(state[x] == GONE)
+            {
+                if(keys[x].empty()) throw std::runtime_error{"Error: unable to read folder \"" + root.string() + "\""};
+                erase_within(t.folders, keys[x]);
+            }
+        }
+        for(std::size_t x{0}; x < keys.size(); ++x)
+        {
+            std::map<std::string, folder>::iterator f{t.folders.find(keys[x])};
+            const path p{keys[x].empty() ? root : (root / keys[x])};
+            std::vector<std::string> names;
+            tree_entry e;
+            
+            if((state[x] != CHANGED) || (f == t.folders.end()) || !inspect(p, e)) continue;
+            f->second = folder{usage{0, 0, 0, e.modified}, e.inode, e.modified, now()};
+            read_directory(p, [&names](const char* name, const boost::filesystem::file_type&, const std::uint64_t&){ names.emplace_back(name); });
+            for(const std::string& name : names)
+            {
+                const std::string child{keys[x].empty() ? name : (keys[x] + '/' + name)};
+                std::uint64_t allocated{0};
+                
+                if(!inspect((p / name), e, &allocated)) continue;
+                f->second.own.newest = std::max(f->second.own.newest, e.modified);
+                if(e.type != boost::filesystem::directory_file)
+                {
+                    f->second.own.bytes += e.size;
+                    f->second.own.allocated += allocated;
+                    ++(f->second.own.files);
+                }
+                else if(t.folders.find(child) == t.folders.end()) this->scan(root, child, t); //new
+            }
+        }
+    }
+    
+    /**
+     * @brief Reads a folder, and everything in it, with parallel_walk, and
+     * replaces what the tree had for it.
+     * @param root The tree's root.
+     * @param relative The folder, relative to root.
+     * @param t The tree.
+     */
+    void usage_cache::scan(const path& root, const std::string& relative, tree& t)
+    {
+        using boost::filesystem::directory_file;
+        
+        const path top{relative.empty() ? root : (root / relative)};
+        const std::size_t offset{root.native().size() + ((!root.native().empty() && (root.native().back() == '/')) ? 0 : 1)};
+        const std::int64_t started{now()};
+        std::map<std::string, folder> found;
+        std::mutex lock;
+        tree_entry e;
+        
+        if(!inspect(top, e) || (e.type != directory_file))
+        {
+            if(relative.empty()) throw std::runtime_error{"Error: unable to read folder \"" + root.string() + "\""};
+            return;
+        }
+        found[relative] = folder{usage{0, 0, 0, e.modified}, e.inode, e.modified, started};
+        
+        parallel_walk(top, [&](const walk_entry& w)
+        {
+            const std::string key{w.path.native().substr(offset)};
+            std::uint64_t allocated{0};
+            tree_entry entry;
+            
+            if(!inspect(w.path, entry, &allocated)) return false;
+            
+            std::lock_guard<std::mutex> l{lock};
+            usage& parent(found[parent_of(key)].own);
+            
+            parent.newest = std::max(parent.newest, entry.modified);
+            if(entry.type == directory_file)
+            {
+                folder& f(found[key]);
+                f.own.newest = std::max(f.own.newest, entry.modified);
+                f.inode = entry.inode;
+                f.modified = entry.modified;
+                f.read = started;
+                return true;
+            }
+            parent.bytes += entry.size;
+            parent.allocated += allocated;
+            ++(parent.files);
+            return false;
+        }, this->threads);
+        
+        erase_within(t.folders, relative);
+        for(std::pair<const std::string, folder>& f : found) t.folders.insert(std::move(f));
+    }
+    
+    
+}
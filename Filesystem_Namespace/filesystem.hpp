@@ -2,7 +2,19 @@
 #define UTILITY_FILESYSTEM_HPP_INCLUDED
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 /** 
  * @author Jonathan Whitlock
@@ -17,6 +29,22 @@ namespace filesystem
     class copy_iterator;
     class glob;
     class recursive_glob;
+    class pattern;
+    struct prune;
+    struct walk_entry;
+    struct copy_progress;
+    struct tree_entry;
+    struct tree_diff;
+    class tree_snapshot;
+    struct watch_event;
+    class watch;
+    struct usage;
+    class usage_cache;
+    
+    void parallel_walk(const boost::filesystem::path&, const std::function<bool(const walk_entry&)>&, const unsigned int& = 0);
+    void parallel_copy(const boost::filesystem::path&, const boost::filesystem::path&, const std::function<void(const copy_progress&)>& = nullptr, const unsigned int& = 0);
+    std::vector<std::vector<boost::filesystem::path> > find_duplicates(const boost::filesystem::path&, const unsigned int& = 0);
+    std::vector<std::vector<boost::filesystem::path> > find_duplicates(const boost::filesystem::path&, const prune&, const unsigned int& = 0);
     
     
     /**
@@ -33,10 +61,12 @@ namespace filesystem
         explicit regular_iterator();
         regular_iterator(const boost::filesystem::path&);
         regular_iterator(const regular_iterator&);
+        regular_iterator(regular_iterator&&) noexcept;
         
         virtual ~regular_iterator();
         
         virtual regular_iterator& operator=(const regular_iterator&);
+        virtual regular_iterator& operator=(regular_iterator&&) noexcept;
         virtual regular_iterator& operator++();
         regular_iterator operator++(int);
         
@@ -50,7 +80,7 @@ namespace filesystem
         bool end() const;
         
     protected:
-        boost::filesystem::path beg_path;
+        std::shared_ptr<const boost::filesystem::path> beg_path; //shared by copies
         boost::filesystem::directory_iterator it;
     };
     
@@ -67,11 +97,14 @@ namespace filesystem
     public:
         explicit recursive_iterator();
         recursive_iterator(const boost::filesystem::path&);
+        recursive_iterator(const boost::filesystem::path&, const prune&);
         recursive_iterator(const recursive_iterator&);
+        recursive_iterator(recursive_iterator&&) noexcept;
         
         virtual ~recursive_iterator();
         
         virtual recursive_iterator& operator=(const recursive_iterator&);
+        virtual recursive_iterator& operator=(recursive_iterator&&) noexcept;
         virtual recursive_iterator& operator++();
         recursive_iterator operator++(int);
         
@@ -85,8 +118,12 @@ namespace filesystem
         bool end() const;
         
     protected:
+        void skip_pruned();
+        bool pruned();
+        
         boost::filesystem::recursive_directory_iterator it;
-        boost::filesystem::path beg_path;
+        std::shared_ptr<const boost::filesystem::path> beg_path; //shared by copies
+        std::shared_ptr<const prune> limits; //shared by copies; null if nothing is pruned
         
     };
     
@@ -95,7 +132,8 @@ namespace filesystem
      * @author Jonathan Whitlock
      * @date 02/16/2016
      * @file filesystem.hpp
-     * @brief Recursively copies a folder into another folder.
+     * @brief Recursively copies a folder into another folder.  It copies one
+     * entry per increment; parallel_copy copies a whole tree much faster.
      */
     class copy_iterator : public recursive_iterator
     {
@@ -103,16 +141,112 @@ namespace filesystem
         explicit copy_iterator();
         copy_iterator(const boost::filesystem::path&, const boost::filesystem::path&);
         copy_iterator(const copy_iterator&);
+        copy_iterator(copy_iterator&&) noexcept;
         virtual ~copy_iterator();
         
         virtual copy_iterator& operator=(const copy_iterator&);
+        virtual copy_iterator& operator=(copy_iterator&&) noexcept;
         virtual copy_iterator& operator++();
         copy_iterator operator++(int);
         
+        void swap(copy_iterator&);
+        
     private:
         boost::filesystem::path source, dest;
     };
     
+    /**
+     * @class pattern
+     * @file filesystem.hpp
+     * @brief A compiled shell-style glob pattern:
+     * 
+     * *      any characters, except '/'
+     * ?      one character, except '/'
+     * [abc]  one of the characters listed; ranges (a-z) and negation ([!a] or [^a]) work
+     * **     any characters, including '/'.  "**" followed by '/' matches any number
+     *        of folders, including none.
+     * \c     the character c
+     * 
+     * Patterns without a '/' are matched against the file name only, and patterns
+     * with one against the path relative to the folder being iterated.  Patterns made
+     * of a literal prefix and/or suffix around a single '*' (like "*.txt") are
+     * matched by comparing them, and the rest by simulating their automaton a character
+     * at a time.  Matching never allocates.  Unlike a shell, '*' matches names that
+     * start with a '.'.
+     */
+    class pattern
+    {
+    public:
+        explicit pattern();
+        pattern(const std::string&);
+        
+        bool matches(const char*, const std::size_t&) const;
+        bool matches(const std::string&) const;
+        bool matches(const boost::filesystem::path&, const boost::filesystem::path&) const;
+        
+        bool empty() const;
+        const std::string& str() const;
+        
+    private:
+        enum class token_type : char
+        {
+            character,
+            any_character,
+            any_of,
+            any, //*
+            any_path, //**
+            folders, //**/
+            folders_inside
+        };
+        
+        struct token
+        {
+            token_type type;
+            char c;
+            std::bitset<256> set;
+        };
+        
+        enum class strategy : char
+        {
+            literal,
+            affixes, //prefix*suffix
+            automaton
+        };
+        
+        bool simulate(const char*, const std::size_t&) const;
+        
+        std::string source, prefix, suffix;
+        std::vector<token> tokens;
+        strategy how;
+        bool whole_path;
+        
+    };
+    
+    /**
+     * @brief Limits where recursive_iterator and recursive_glob go, so that
+     * the parts of a tree that don't matter aren't read at all.
+     * 
+     * filesystem::prune p;
+     * p.folders = {filesystem::pattern{".git"}, filesystem::pattern{"build*"}};
+     * p.max_depth = 3;
+     * for(filesystem::recursive_glob it{root, filesystem::pattern{"*.cpp"}, p}; !it.end(); ++it) ...
+     */
+    struct prune
+    {
+        //folders that match one of these patterns, or that skip_folder returns true for,
+        //are skipped:  neither visited nor entered.
+        std::vector<pattern> folders;
+        std::function<bool(const boost::filesystem::directory_entry&)> skip_folder;
+        
+        //folders this deep are visited but not entered.  The entries of the folder
+        //being iterated are at depth 0.  Negative for no limit.
+        int max_depth{-1};
+        
+        //files outside of these limits are skipped.  Checking them needs a stat.
+        std::uintmax_t min_size{0}, max_size{std::numeric_limits<std::uintmax_t>::max()};
+        std::time_t modified_after{0};
+    };
+    
     /**
      * @class glob
      * @author Jonathan Whitlock
@@ -120,25 +254,34 @@ namespace filesystem
      * @file filesystem.hpp
      * @brief A non-recursive glob iterator.  Iterates only
      * over entries that match a regular expression.  By default, uses the search
-     * algorithm instead of the exact match algorithm.
+     * algorithm instead of the exact match algorithm.  Constructed with a
+     * pattern, it matches the pattern instead, which is much faster.
+     * Copies share the expression or pattern, so copying doesn't allocate.
      */
     class glob : public regular_iterator
     {
     public:
         explicit glob();
         glob(const glob&);
+        glob(glob&&) noexcept;
         glob(const boost::filesystem::path&, const std::string& = "", const bool& = false);
+        glob(const boost::filesystem::path&, const pattern&);
         virtual ~glob();
         
         virtual glob& operator=(const glob&);
+        virtual glob& operator=(glob&&) noexcept;
         virtual glob& operator++();
         glob operator++(int);
         
+        void swap(glob&);
+        
     private:
         bool matches() const;
     
-        boost::regex expression;
+        //compiled once, and shared by copies:
+        std::shared_ptr<const boost::regex> expression;
         bool exact_match;
+        std::shared_ptr<const pattern> compiled; //used instead of expression when it's not null
         
     };
     
@@ -149,25 +292,289 @@ namespace filesystem
      * @file filesystem.hpp
      * @brief A recursive glob iterator.  Iterates only
      * over entries that match a regular expression.  By default, uses the search
-     * algorithm instead of the exact match algorithm.
+     * algorithm instead of the exact match algorithm.  Constructed with a
+     * pattern, it matches the pattern instead, which is much faster.
+     * Copies share the expression or pattern, so copying doesn't allocate.
      */
     class recursive_glob : public recursive_iterator
     {
     public:
         explicit recursive_glob();
         recursive_glob(const recursive_glob&);
+        recursive_glob(recursive_glob&&) noexcept;
         recursive_glob(const boost::filesystem::path&, const std::string& = "", const bool& = false);
+        recursive_glob(const boost::filesystem::path&, const pattern&);
+        recursive_glob(const boost::filesystem::path&, const pattern&, const prune&);
         virtual ~recursive_glob();
         
         virtual recursive_glob& operator=(const recursive_glob&);
+        virtual recursive_glob& operator=(recursive_glob&&) noexcept;
         virtual recursive_glob& operator++();
         recursive_glob operator++(int);
         
+        void swap(recursive_glob&);
+        
     private:
         bool matches() const;
     
-        boost::regex expression;
+        //compiled once, and shared by copies:
+        std::shared_ptr<const boost::regex> expression;
         bool exact_match;
+        std::shared_ptr<const pattern> compiled; //used instead of expression when it's not null
+        
+    };
+    
+    /**
+     * @brief An entry found by parallel_walk.  type is taken from the directory
+     * itself when the filesystem provides it, so symlinks are reported as
+     * symlink_file and never followed.
+     */
+    struct walk_entry
+    {
+        boost::filesystem::path path;
+        boost::filesystem::file_type type;
+        std::uint64_t inode;
+        unsigned int depth; //0 for the entries of the folder walked
+    };
+    
+    /**
+     * @brief How far parallel_copy has gotten.
+     */
+    struct copy_progress
+    {
+        std::uint64_t files, files_total, bytes, bytes_total;
+        double seconds, bytes_per_second;
+    };
+    
+    /**
+     * @brief What a tree_snapshot records about one entry.
+     */
+    struct tree_entry
+    {
+        boost::filesystem::file_type type;
+        std::uint64_t inode, size;
+        std::int64_t modified; //nanoseconds since the epoch
+        std::uint32_t crc; //CRC-32C of a regular file's contents, if hashed
+        bool hashed;
+        std::vector<std::string> names; //a folder's entries, sorted
+    };
+    
+    /**
+     * @brief The paths, relative to the root, that differ between two
+     * tree_snapshots.  Each list is sorted.
+     */
+    struct tree_diff
+    {
+        std::vector<std::string> added, removed, changed;
+    };
+    
+    /**
+     * @class tree_snapshot
+     * @file filesystem.hpp
+     * @brief A record of every entry in a tree (its type, inode, size,
+     * modification time, and optionally a checksum of its contents) that can be
+     * saved, and compared against a later scan to find what was added, removed
+     * and changed since.
+     * 
+     * filesystem::tree_snapshot before{root};
+     * ...
+     * filesystem::tree_snapshot after{before.rescan()};
+     * filesystem::tree_diff d{before.diff(after)};
+     * 
+     * rescan doesn't read folders whose modification time hasn't changed since
+     * the snapshot; it reuses their list of entries instead, because a folder's
+     * modification time changes whenever an entry is added to, removed from, or
+     * renamed within it.  It doesn't change when a file in it is written to, so
+     * every entry is still stat'ed, and subfolders are still visited.  Folders
+     * modified within 2 seconds before the snapshot was taken are read anyway,
+     * since timestamps can be too coarse to tell a later change apart.
+     * 
+     * With hashing on, files that were touched without their contents changing
+     * aren't reported as changed.  rescan only hashes files that were modified.
+     * 
+     * Paths use '/', the root's own entry is "", and symlinks aren't followed.
+     */
+    class tree_snapshot
+    {
+    public:
+        explicit tree_snapshot();
+        tree_snapshot(const boost::filesystem::path&, const bool& = false);
+        
+        tree_snapshot rescan() const;
+        tree_diff diff(const tree_snapshot&) const;
+        
+        const boost::filesystem::path& root() const;
+        const std::map<std::string, tree_entry>& entries() const;
+        
+        friend std::ostream& operator<<(std::ostream&, const tree_snapshot&);
+        friend std::istream& operator>>(std::istream&, tree_snapshot&);
+        
+    private:
+        void scan(const tree_snapshot*);
+        
+        boost::filesystem::path folder;
+        bool hash;
+        std::int64_t taken; //nanoseconds since the epoch
+        std::map<std::string, tree_entry> all; //relative path -> entry
+        
+    };
+    
+    std::ostream& operator<<(std::ostream&, const tree_snapshot&);
+    std::istream& operator>>(std::istream&, tree_snapshot&);
+    
+    enum class watch_change
+    {
+        created,
+        modified,
+        removed,
+        moved,
+        lost //events were dropped, so the tree should be read again
+    };
+    
+    /**
+     * @brief A change reported by a watch.
+     */
+    struct watch_event
+    {
+        watch_change change;
+        boost::filesystem::path path;
+        boost::filesystem::path from; //where a moved entry was
+        bool folder;
+    };
+    
+    /**
+     * @class watch
+     * @file filesystem.hpp
+     * @brief Reports changes to a folder, and all of its subfolders, as they
+     * happen.  It's backed by inotify, so it's only available on Linux;
+     * elsewhere the constructor throws.  Like glob, construction moves to the
+     * first change, and each increment moves to the next one:
+     * 
+     * for(filesystem::watch w{root}; !w.end(); ++w)
+     * {
+     *     if(w->change == filesystem::watch_change::created) ...
+     * }
+     * 
+     * Incrementing waits until something changes.  Changes that happen close
+     * together (within 10 milliseconds of each other) are coalesced by path:
+     * a file written several times is reported as modified once, and a file
+     * created and removed again isn't reported at all.  If a timeout is given,
+     * the watch ends once nothing has changed for that long;  incrementing it
+     * again waits again.  It also ends when the folder is removed or moved.
+     * 
+     * Folders created in the tree are watched too, and what's already in them
+     * when they're found is reported as created.  Entries moved within the
+     * tree are reported as moved, and entries moved in or out of it are
+     * reported as created or removed.
+     * 
+     * This is non-copyable, and non-movable.
+     */
+    class watch
+    {
+    private:
+        watch(const watch&) = delete;
+        watch(watch&&) = delete;
+        
+        watch& operator=(const watch&) = delete;
+        watch& operator=(watch&&) = delete;
+        
+    public:
+        explicit watch(const boost::filesystem::path&, const std::chrono::milliseconds& = std::chrono::milliseconds{0});
+        ~watch();
+        
+        watch& operator++();
+        
+        const watch_event& operator*() const;
+        const watch_event* operator->() const;
+        
+        bool end() const;
+        
+    private:
+        void add(const boost::filesystem::path&, const std::function<void(const boost::filesystem::path&, const bool&)>&);
+        void forget(const boost::filesystem::path&);
+        void read(const int&);
+        
+        boost::filesystem::path root;
+        std::chrono::milliseconds timeout;
+        int fd;
+        std::map<int, boost::filesystem::path> folders; //watch descriptor -> folder
+        std::deque<watch_event> queue;
+        watch_event current;
+        bool removed, at_end;
+        
+    };
+    
+    /**
+     * @brief What's in a folder, and all of its subfolders.  Files linked more
+     * than once are counted once for each link.
+     */
+    struct usage
+    {
+        std::uint64_t bytes, allocated; //the size of the files, and the space allocated to them
+        std::uint64_t files; //everything but folders
+        std::int64_t newest; //the newest modification time of the folder and what's in it, in nanoseconds since the epoch
+    };
+    
+    /**
+     * @class usage_cache
+     * @file filesystem.hpp
+     * @brief Measures how much is stored in each folder of a tree, like du,
+     * and keeps the result so that the next query only has to check what
+     * changed.
+     * 
+     * filesystem::usage_cache cache;
+     * std::uint64_t used{cache.total(root).allocated};
+     * 
+     * The first query reads the whole tree, on several threads.  Later queries
+     * stat every folder, but only read the folders whose modification time
+     * changed (an entry was added, removed or renamed in them), and the
+     * subfolders that are new.  A file that's written to in place doesn't
+     * change its folder's modification time, though, so once the time to live
+     * has passed, the whole tree is read again.  Folders modified within 2
+     * seconds before they were read are read again too, since timestamps can
+     * be too coarse to tell a later change apart.
+     * 
+     * It's safe to use from several threads;  queries are run one at a time.
+     * 
+     * This is non-copyable, and non-movable.
+     */
+    class usage_cache
+    {
+    private:
+        usage_cache(const usage_cache&) = delete;
+        usage_cache(usage_cache&&) = delete;
+        
+        usage_cache& operator=(const usage_cache&) = delete;
+        usage_cache& operator=(usage_cache&&) = delete;
+        
+    public:
+        explicit usage_cache(const std::chrono::milliseconds& = std::chrono::minutes{1}, const unsigned int& = 0);
+        
+        std::map<std::string, usage> folders(const boost::filesystem::path&);
+        usage total(const boost::filesystem::path&);
+        void forget(const boost::filesystem::path&);
+        
+    private:
+        struct folder
+        {
+            usage own; //of the entries directly inside
+            std::uint64_t inode;
+            std::int64_t modified, read; //nanoseconds since the epoch
+        };
+        
+        struct tree
+        {
+            std::map<std::string, folder> folders; //relative path -> folder, "" is the root
+            std::chrono::steady_clock::time_point read; //when it was last read entirely
+        };
+        
+        void refresh(const boost::filesystem::path&, tree&);
+        void scan(const boost::filesystem::path&, const std::string&, tree&);
+        
+        std::chrono::milliseconds ttl;
+        unsigned int threads;
+        std::mutex m;
+        std::map<boost::filesystem::path, tree> trees;
         
     };
     
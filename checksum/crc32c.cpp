@@ -0,0 +1,130 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "crc32c.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CHECKSUM_CRC32C_SSE42 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CHECKSUM_CRC32C_ARM 1
+#endif
+
+namespace
+{
+    constexpr std::uint32_t POLYNOMIAL{0x82f63b78}; //reversed Castagnoli polynomial
+    
+    const std::array<std::uint32_t, 256>& table();
+    std::uint32_t crc_table(const unsigned char*, std::size_t, std::uint32_t);
+    
+    
+    const std::array<std::uint32_t, 256>& table()
+    {
+        static const std::array<std::uint32_t, 256> t{[]()
+        {
+            std::array<std::uint32_t, 256> entries;
+            for(std::uint32_t x{0}; x < 256; ++x)
+            {
+                std::uint32_t c{x};
+                for(unsigned int bit{0}; bit < 8; ++bit) c = ((c & 1) ? ((c >> 1) ^ POLYNOMIAL) : (c >> 1));
+                entries[x] = c;
+            }
+            return entries;
+        }()};
+        return t;
+    }
+    
+    std::uint32_t crc_table(const unsigned char* p, std::size_t n, std::uint32_t c)
+    {
+        const std::array<std::uint32_t, 256>& t(table());
+        
+        for(; n > 0; --n, ++p) c = (t[(c ^ *p) & 0xff] ^ (c >> 8));
+        return c;
+    }
+    
+#ifdef CHECKSUM_CRC32C_SSE42
+    __attribute__((target("sse4.2")))
+    std::uint32_t crc_hardware(const unsigned char* p, std::size_t n, std::uint32_t crc)
+    {
+        std::uint64_t c{crc};
+        
+        for(; n >= 8; n -= 8, p += 8)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            c = _mm_crc32_u64(c, v);
+        }
+        crc = (std::uint32_t)c;
+        for(; n > 0; --n, ++p) crc = _mm_crc32_u8(crc, *p);
+        return crc;
+    }
+    
+    bool supported()
+    {
+        static const bool s{__builtin_cpu_supports("sse4.2") != 0};
+        return s;
+    }
+#elif defined(CHECKSUM_CRC32C_ARM)
+    std::uint32_t crc_hardware(const unsigned char* p, std::size_t n, std::uint32_t crc)
+    {
+        for(; n >= 8; n -= 8, p += 8)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            crc = __crc32cd(crc, v);
+        }
+        for(; n > 0; --n, ++p) crc = __crc32cb(crc, *p);
+        return crc;
+    }
+    
+    constexpr bool supported()
+    {
+        return true;
+    }
+#endif
+    
+    
+}
+
+namespace checksum
+{
+    /**
+     * @brief Computes the CRC-32C of n bytes.
+     * @param data The bytes.
+     * @param n How many bytes.
+     * @param crc The CRC of the data that came before, to checksum data in pieces.
+     * @return The CRC.
+     */
+    std::uint32_t crc32c(const void* data, const std::size_t& n, const std::uint32_t& crc)
+    {
+        const unsigned char* p{static_cast<const unsigned char*>(data)};
+        
+#if defined(CHECKSUM_CRC32C_SSE42) || defined(CHECKSUM_CRC32C_ARM)
+        if(supported()) return ~crc_hardware(p, n, ~crc);
+#endif
+        return ~crc_table(p, n, ~crc);
+    }
+    
+    std::uint32_t crc32c(const std::string& s, const std::uint32_t& crc)
+    {
+        return crc32c(s.data(), s.size(), crc);
+    }
+    
+    /**
+     * @return true if crc32c uses the CPU's CRC instructions.
+     */
+    bool hardware_crc32c()
+    {
+#if defined(CHECKSUM_CRC32C_SSE42) || defined(CHECKSUM_CRC32C_ARM)
+        return supported();
+#else
+        return false;
+#endif
+    }
+    
+    
+}
@@ -0,0 +1,21 @@
+#ifndef CHECKSUM_CRC32C_HPP_INCLUDED
+#define CHECKSUM_CRC32C_HPP_INCLUDED
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief CRC-32C (Castagnoli), the checksum used by iSCSI, ext4 and btrfs.
+ * Computed with the CPU's CRC instructions where there are any (SSE 4.2 on x86-64,
+ * checked at run time;  the CRC extension on ARMv8, checked at compile time), and with
+ * a lookup table otherwise.
+ */
+namespace checksum
+{
+    std::uint32_t crc32c(const void*, const std::size_t&, const std::uint32_t& = 0);
+    std::uint32_t crc32c(const std::string&, const std::uint32_t& = 0);
+    bool hardware_crc32c();
+    
+}
+
+#endif
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "async_io.hpp"
+
+namespace
+{
+	bool read_rest(const int&, std::string&, std::size_t);
+
+
+
+	/*
+	Reads the file from "done" bytes to the end of the string with pread.
+	*/
+	bool read_rest(const int& fd, std::string& data, std::size_t done)
+	{
+		while(done < data.size())
+		{
+			ssize_t r{::pread(fd, (&data[0] + done), (data.size() - done), done)};
+			if(r < 0)
+			{
+				if(errno == EINTR) continue;
+				return false;
+			}
+			if(r == 0)
+			{
+				data.resize(done); //it shrank since it was measured
+				break;
+			}
+			done += r;
+		}
+		return true;
+	}
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(IORING_OP_READ)
+	/*
+	Just enough of io_uring to read a batch of files:  the rings are mapped, read
+	requests are queued on the submission ring, and io_uring_enter submits them
+	and waits for completions, which are taken off the completion ring.
+	*/
+	class ring
+	{
+	private:
+		ring(const ring&) = delete;
+		ring(ring&&) = delete;
+
+		ring& operator=(const ring&) = delete;
+		ring& operator=(ring&&) = delete;
+
+	public:
+		explicit ring(const unsigned int& entries) :
+				fd{-1},
+				params{},
+				sq_ptr{MAP_FAILED},
+				cq_ptr{MAP_FAILED},
+				sqes{static_cast<io_uring_sqe*>(MAP_FAILED)},
+				sq_size{0},
+				cq_size{0},
+				queued{0}
+		{
+			this->fd = ::syscall(__NR_io_uring_setup, entries, &(this->params));
+			if(this->fd < 0) return;
+
+			this->sq_size = (this->params.sq_off.array + (this->params.sq_entries * sizeof(unsigned)));
+			this->cq_size = (this->params.cq_off.cqes + (this->params.cq_entries * sizeof(io_uring_cqe)));
+			if(this->params.features & IORING_FEAT_SINGLE_MMAP) this->sq_size = this->cq_size = std::max(this->sq_size, this->cq_size);
+
+			this->sq_ptr = ::mmap(nullptr, this->sq_size, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), this->fd, IORING_OFF_SQ_RING);
+			if(this->sq_ptr == MAP_FAILED) return;
+			if(this->params.features & IORING_FEAT_SINGLE_MMAP) this->cq_ptr = this->sq_ptr;
+			else this->cq_ptr = ::mmap(nullptr, this->cq_size, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), this->fd, IORING_OFF_CQ_RING);
+			if(this->cq_ptr == MAP_FAILED) return;
+			this->sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, (this->params.sq_entries * sizeof(io_uring_sqe)),
+					(PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), this->fd, IORING_OFF_SQES));
+		}
+
+		~ring()
+		{
+			if(this->sqes != MAP_FAILED) ::munmap(this->sqes, (this->params.sq_entries * sizeof(io_uring_sqe)));
+			if((this->cq_ptr != MAP_FAILED) && (this->cq_ptr != this->sq_ptr)) ::munmap(this->cq_ptr, this->cq_size);
+			if(this->sq_ptr != MAP_FAILED) ::munmap(this->sq_ptr, this->sq_size);
+			if(this->fd >= 0) ::close(this->fd);
+		}
+
+		bool good() const
+		{
+			return ((this->fd >= 0) && (this->sqes != MAP_FAILED));
+		}
+
+		unsigned int capacity() const
+		{
+			return this->params.sq_entries;
+		}
+
+		/*
+		Queues a read of "length" bytes at the start of the file into "into".
+		*/
+		void read(const int& file, char* into, const std::size_t& length, const std::uint64_t& tag)
+		{
+			unsigned* tail{this->sq(this->params.sq_off.tail)};
+			unsigned t{*tail}, index{t & *(this->sq(this->params.sq_off.ring_mask))};
+			io_uring_sqe& e(this->sqes[index]);
+
+			std::memset(&e, 0, sizeof(e));
+			e.opcode = IORING_OP_READ;
+			e.fd = file;
+			e.addr = reinterpret_cast<std::uint64_t>(into);
+			e.len = length;
+			e.off = 0;
+			e.user_data = tag;
+			this->sq(this->params.sq_off.array)[index] = index;
+			__atomic_store_n(tail, (t + 1), __ATOMIC_RELEASE);
+			++(this->queued);
+		}
+
+		/*
+		Submits what's queued, waits for at least one completion, and passes each
+		completion's tag and result to "done".  Returns false if io_uring_enter fails.
+		*/
+		bool wait(const std::function<void(const std::uint64_t&, const int&)>& done)
+		{
+			unsigned* head{this->cq(this->params.cq_off.head)};
+			unsigned* tail{this->cq(this->params.cq_off.tail)};
+			unsigned mask{*(this->cq(this->params.cq_off.ring_mask))};
+			io_uring_cqe* cqes{reinterpret_cast<io_uring_cqe*>(static_cast<char*>(this->cq_ptr) + this->params.cq_off.cqes)};
+
+			while(::syscall(__NR_io_uring_enter, this->fd, this->queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+			{
+				if(errno != EINTR) return false;
+			}
+			this->queued = 0;
+
+			for(unsigned h{*head}; h != __atomic_load_n(tail, __ATOMIC_ACQUIRE); ++h)
+			{
+				io_uring_cqe& c(cqes[h & mask]);
+				done(c.user_data, c.res);
+				__atomic_store_n(head, (h + 1), __ATOMIC_RELEASE);
+			}
+			return true;
+		}
+
+	private:
+		unsigned* sq(const unsigned& offset)
+		{
+			return reinterpret_cast<unsigned*>(static_cast<char*>(this->sq_ptr) + offset);
+		}
+
+		unsigned* cq(const unsigned& offset)
+		{
+			return reinterpret_cast<unsigned*>(static_cast<char*>(this->cq_ptr) + offset);
+		}
+
+		int fd;
+		io_uring_params params;
+		void *sq_ptr, *cq_ptr;
+		io_uring_sqe* sqes;
+		std::size_t sq_size, cq_size;
+		unsigned int queued;
+
+	};
+#define UTILITY_ASYNC_IO_URING 1
+#endif
+
+
+}
+
+namespace utility
+{
+	/**
+	 * @brief Reads whole files.  They're opened, read and closed in batches of
+	 * 64, so that a large folder can't use up the process's file descriptors.  On
+	 * Linux, each batch is submitted to io_uring, so that many reads are in
+	 * flight at once from a single thread.  If io_uring isn't available, they're
+	 * read one after the other.
+	 * @param files The files to read.
+	 * @param data Set to the contents of each file.
+	 * @return Whether each file was read.  Files that don't exist (anymore) aren't.
+	 * @throw std::runtime_error if a file that exists can't be opened.
+	 */
+	std::vector<bool> read_files(const std::vector<boost::filesystem::path>& files, std::vector<std::string>& data)
+	{
+		constexpr std::size_t BATCH{64};
+		std::vector<bool> read(files.size(), false);
+		std::vector<int> fds; //of the current batch
+
+		auto close_all = [&fds]()
+		{
+			for(int& fd : fds)
+			{
+				if(fd >= 0) ::close(fd);
+			}
+			fds.clear();
+		};
+
+#ifdef UTILITY_ASYNC_IO_URING
+		ring r{BATCH};
+		bool use_ring{r.good() && (r.capacity() >= BATCH)};
+#endif
+
+		data.assign(files.size(), std::string{});
+		for(std::size_t first{0}; first < files.size(); first += BATCH)
+		{
+			std::size_t last{std::min(files.size(), (first + BATCH))};
+
+			for(std::size_t x{first}; x < last; ++x)
+			{
+				struct stat st;
+				int fd{::open(files[x].string().c_str(), (O_RDONLY | O_CLOEXEC))};
+
+				//a file removed since it was listed just isn't read, like one that can't be read:
+				if((fd < 0) && (errno != ENOENT))
+				{
+					std::string error{std::strerror(errno)};
+					close_all();
+					throw std::runtime_error{"Error: unable to open \"" + files[x].string() + "\": " + error};
+				}
+				fds.push_back(fd);
+				if(fd < 0) continue;
+				if((::fstat(fd, &st) != 0) || !S_ISREG(st.st_mode))
+				{
+					::close(fd);
+					fds.back() = -1;
+					continue;
+				}
+				data[x].resize(st.st_size);
+			}
+
+#ifdef UTILITY_ASYNC_IO_URING
+			if(use_ring)
+			{
+				std::size_t in_flight{0};
+
+				auto done = [&](const std::uint64_t& x, const int& result)
+				{
+					--in_flight;
+					if(result < 0) read[x] = read_rest(fds[x - first], data[x], 0); //the kernel may not support the operation
+					else read[x] = read_rest(fds[x - first], data[x], result);
+				};
+
+				for(std::size_t x{first}; x < last; ++x)
+				{
+					if(fds[x - first] < 0) continue;
+					if(data[x].empty())
+					{
+						read[x] = true;
+						continue;
+					}
+					r.read(fds[x - first], &data[x][0], data[x].size(), x);
+					++in_flight;
+				}
+				while(use_ring && (in_flight > 0)) use_ring = r.wait(done);
+			}
+#endif
+
+			//whatever io_uring didn't read:
+			for(std::size_t x{first}; x < last; ++x)
+			{
+				if((fds[x - first] >= 0) && !read[x]) read[x] = read_rest(fds[x - first], data[x], 0);
+			}
+			close_all();
+		}
+		return read;
+	}
+
+
+}
+
+/* io_pool member functions: */
+namespace utility
+{
+	io_pool::io_pool(const unsigned int& count) :
+			m{},
+			ready{},
+			tasks{},
+			stopping{false},
+			threads{}
+	{
+		for(unsigned int x{0}; x < count; ++x) this->threads.emplace_back(&io_pool::work, this);
+	}
+
+	/**
+	 * @brief Finishes the tasks that were submitted, and joins the threads.
+	 */
+	io_pool::~io_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{this->m};
+			this->stopping = true;
+		}
+		this->ready.notify_all();
+		for(std::thread& t : this->threads) t.join();
+	}
+
+	io_pool& io_pool::get()
+	{
+		static io_pool pool{std::max(2u, std::thread::hardware_concurrency())};
+		return pool;
+	}
+
+	void io_pool::work()
+	{
+		while(true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock{this->m};
+				this->ready.wait(lock, [this](){ return (this->stopping || !this->tasks.empty()); });
+				if(this->tasks.empty()) return;
+				task = std::move(this->tasks.front());
+				this->tasks.pop();
+			}
+			task();
+		}
+	}
+
+
+}
@@ -0,0 +1,76 @@
+#ifndef UTILITY_ASYNC_IO_HPP_INCLUDED
+#define UTILITY_ASYNC_IO_HPP_INCLUDED
+#include <boost/filesystem.hpp>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace utility
+{
+	std::vector<bool> read_files(const std::vector<boost::filesystem::path>&, std::vector<std::string>&);
+
+	/**
+	 * @class io_pool
+	 * @file async_io.hpp
+	 * @brief The threads that run file_loader's asynchronous functions.  There's
+	 * one per hardware thread (at least 2), created the first time it's used,
+	 * and joined when the program exits.
+	 *
+	 * This is non-copyable, and non-movable.
+	 */
+	class io_pool
+	{
+	private:
+		io_pool(const io_pool&) = delete;
+		io_pool(io_pool&&) = delete;
+
+		io_pool& operator=(const io_pool&) = delete;
+		io_pool& operator=(io_pool&&) = delete;
+
+		explicit io_pool(const unsigned int&);
+
+	public:
+		~io_pool();
+
+		static io_pool& get();
+
+		/**
+		 * @brief Runs f on one of the pool's threads.
+		 * @return A future for f's result.  Exceptions thrown by f are
+		 * rethrown by the future's get().
+		 */
+		template<typename function_t>
+		auto submit(function_t&& f) -> std::future<decltype(f())>
+		{
+			auto task = std::make_shared<std::packaged_task<decltype(f())()> >(std::forward<function_t>(f));
+			std::future<decltype(f())> result{task->get_future()};
+
+			{
+				std::lock_guard<std::mutex> lock{this->m};
+				this->tasks.emplace([task](){ (*task)(); });
+			}
+			this->ready.notify_one();
+			return result;
+		}
+
+	private:
+		void work();
+
+		std::mutex m;
+		std::condition_variable ready;
+		std::queue<std::function<void()> > tasks;
+		bool stopping;
+		std::vector<std::thread> threads;
+
+	};
+
+
+}
+
+#endif
@@ -0,0 +1,331 @@
+/**
+Measures the throughput and latency of file_loader's operations on folders of
+synthetic objects, and prints the results as CSV or JSON so that runs can be
+compared.
+
+Build (from this folder):
+
+	g++ -std=c++14 -O2 -I.. -I../../Filesystem_Namespace -I../../stream_ops -I../../checksum -I../../worker_thread \
+		file_loader_benchmark.cpp ../async_io.cpp ../../Filesystem_Namespace/filesystem.cpp \
+		../../stream_ops/stream_operations.cpp ../../checksum/crc32c.cpp \
+		-lboost_filesystem -lboost_regex -lboost_system -lpthread -lz -o file_loader_benchmark
+
+Options:
+	--counts=1000,10000,100000,1000000    Objects each folder is generated with.  The
+	                                      saves measured add --samples more, so the
+	                                      rows after them report the larger count.
+	--size=256                            Bytes of payload in each object.
+	--samples=1000                        Calls timed for the operations on one object
+	                                      (save, load, remove).
+	--repeat=5                            Calls timed for the operations on the whole
+	                                      folder (ids, load_all, load_basic).
+	--folder=<temp>/file_loader_benchmark Where the folders are generated.  It's deleted.
+	--format=csv|json
+	--no-sync                             Calls utility::set_sync(false).
+
+Each operation is reported with its number of calls, the total time, its throughput
+in objects per second, and the 50th and 99th percentile latency of a call in
+microseconds.  Reads are measured twice:  "cold" after the folder's files were
+evicted from the page cache (posix_fadvise), and "warm" right after.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stream_operations.hpp"
+
+//the functions are instantiated for bench_object below, so they're compiled here:
+#include "file_loader.cpp"
+
+namespace
+{
+	struct bench_object;
+	struct options;
+	struct result;
+
+	std::ostream& operator<<(std::ostream&, const bench_object&);
+	std::istream& operator>>(std::istream&, bench_object&);
+	std::vector<std::uint64_t> parse_counts(const std::string&);
+	options parse_options(int, char**);
+	void evict(const boost::filesystem::path&);
+	result measure(const std::string&, const std::string&, const std::size_t&, const std::size_t&, const std::function<void(const std::size_t&)>&);
+	void print(const std::vector<result>&, const options&);
+
+
+
+	struct bench_object
+	{
+		static constexpr const char* const EXTENSION{".bench"};
+
+		static boost::filesystem::path& folder()
+		{
+			static boost::filesystem::path p;
+			return p;
+		}
+
+		static utility::ID_T load_id(std::istream& in)
+		{
+			bench_object b;
+			utility::in_mem(in, b.id);
+			return b.id;
+		}
+
+		static bench_object basic(std::istream& in)
+		{
+			bench_object b;
+			utility::in_mem(in, b.id);
+			utility::read_string(in, b.name);
+			return b;
+		}
+
+		utility::ID_T id{0};
+		std::string name, payload;
+	};
+
+	struct options
+	{
+		std::vector<std::uint64_t> counts{1000, 10000, 100000, 1000000};
+		std::size_t size{256}, samples{1000}, repeat{5};
+		boost::filesystem::path folder{boost::filesystem::temp_directory_path() / "file_loader_benchmark"};
+		bool json{false}, sync{true};
+	};
+
+	struct result
+	{
+		std::uint64_t count;
+		std::string operation, cache;
+		std::size_t calls;
+		double seconds, throughput, p50, p99;
+	};
+
+	std::ostream& operator<<(std::ostream& out, const bench_object& b)
+	{
+		utility::out_mem(out, b.id);
+		utility::write_string(out, b.name);
+		utility::write_string(out, b.payload);
+		return out;
+	}
+
+	std::istream& operator>>(std::istream& in, bench_object& b)
+	{
+		utility::in_mem(in, b.id);
+		utility::read_string(in, b.name);
+		utility::read_string(in, b.payload);
+		return in;
+	}
+
+	std::vector<std::uint64_t> parse_counts(const std::string& s)
+	{
+		std::vector<std::uint64_t> counts;
+		std::istringstream in{s};
+		std::string count;
+
+		while(std::getline(in, count, ',')) counts.push_back(std::stoull(count));
+		return counts;
+	}
+
+	options parse_options(int argc, char** argv)
+	{
+		options o;
+
+		for(int x{1}; x < argc; ++x)
+		{
+			std::string arg{argv[x]}, value;
+			std::string::size_type equals{arg.find('=')};
+
+			if(equals != std::string::npos)
+			{
+				value = arg.substr(equals + 1);
+				arg.erase(equals);
+			}
+			if(arg == "--counts") o.counts = parse_counts(value);
+			else if(arg == "--size") o.size = std::stoull(value);
+			else if(arg == "--samples") o.samples = std::stoull(value);
+			else if(arg == "--repeat") o.repeat = std::stoull(value);
+			else if(arg == "--folder") o.folder = value;
+			else if(arg == "--format") o.json = (value == "json");
+			else if(arg == "--no-sync") o.sync = false;
+			else throw std::runtime_error{"Error: unknown option \"" + arg + "\""};
+		}
+		if((o.samples == 0) || (o.repeat == 0)) throw std::runtime_error{"Error: --samples and --repeat must be at least 1"};
+		return o;
+	}
+
+	/*
+	Drops the folder's files from the page cache, so that the next reads go to the disk.
+	Dirty pages can't be dropped, so the files are written out first.
+	*/
+	void evict(const boost::filesystem::path& folder)
+	{
+		for(boost::filesystem::directory_iterator it{folder}; it != boost::filesystem::directory_iterator{}; ++it)
+		{
+			int fd{::open(it->path().string().c_str(), O_RDONLY)};
+			if(fd < 0) continue;
+			::fdatasync(fd);
+#ifdef POSIX_FADV_DONTNEED
+			::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+			::close(fd);
+		}
+	}
+
+	/*
+	Times "calls" calls of f, each of which handles "objects" objects.
+	*/
+	result measure(const std::string& operation, const std::string& cache, const std::size_t& calls, const std::size_t& objects, const std::function<void(const std::size_t&)>& f)
+	{
+		using clock = std::chrono::steady_clock;
+
+		std::vector<double> latency;
+		result r{0, operation, cache, calls, 0, 0, 0, 0};
+
+		latency.reserve(calls);
+		for(std::size_t x{0}; x < calls; ++x)
+		{
+			clock::time_point start{clock::now()};
+			f(x);
+			latency.push_back(std::chrono::duration<double>(clock::now() - start).count());
+			r.seconds += latency.back();
+		}
+		std::sort(latency.begin(), latency.end());
+
+		//nearest rank:
+		auto percentile = [&latency](const double& p){ return (latency[static_cast<std::size_t>(std::max(1.0, std::ceil(p * latency.size()))) - 1] * 1e6); };
+		r.p50 = percentile(0.50);
+		r.p99 = percentile(0.99);
+		r.throughput = ((r.seconds > 0) ? ((calls * objects) / r.seconds) : 0);
+		return r;
+	}
+
+	void print(const std::vector<result>& results, const options& o)
+	{
+		std::cout<< std::fixed<< std::setprecision(3);
+		if(!o.json)
+		{
+			std::cout<< "objects,size,operation,cache,calls,seconds,objects_per_second,p50_us,p99_us"<< std::endl;
+			for(const result& r : results)
+			{
+				std::cout<< r.count<< ','<< o.size<< ','<< r.operation<< ','<< r.cache<< ','<< r.calls<< ','<< r.seconds<< ','
+						<< r.throughput<< ','<< r.p50<< ','<< r.p99<< std::endl;
+			}
+			return;
+		}
+
+		std::cout<< "["<< std::endl;
+		for(std::size_t x{0}; x < results.size(); ++x)
+		{
+			const result& r(results[x]);
+			std::cout<< "  {\"objects\": "<< r.count<< ", \"size\": "<< o.size<< ", \"operation\": \""<< r.operation<< "\", \"cache\": \""<< r.cache
+					<< "\", \"calls\": "<< r.calls<< ", \"seconds\": "<< r.seconds<< ", \"objects_per_second\": "<< r.throughput
+					<< ", \"p50_us\": "<< r.p50<< ", \"p99_us\": "<< r.p99<< "}"<< ((x + 1) < results.size() ? "," : "")<< std::endl;
+		}
+		std::cout<< "]"<< std::endl;
+	}
+
+
+}
+
+namespace utility
+{
+	template void                      save      <bench_object>(bench_object& t, const boost::filesystem::path& folder);
+	template std::set<ID_T>            ids       <bench_object>(const boost::filesystem::path& folder);
+	template std::vector<bench_object> load_all  <bench_object>(const boost::filesystem::path& folder);
+	template void                      remove    <bench_object>(const ID_T& id, const boost::filesystem::path& folder);
+	template void                      save_many <bench_object>(std::vector<bench_object>& t, const boost::filesystem::path& folder);
+	template bench_object              load      <bench_object>(const ID_T& id, const boost::filesystem::path& folder);
+	template std::vector<bench_object> load_basic<bench_object>(const boost::filesystem::path& folder);
+
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		options o{parse_options(argc, argv)};
+		std::vector<result> results;
+		std::mt19937_64 random{42};
+		std::string payload(o.size, 'x');
+
+		utility::set_sync(o.sync);
+		for(std::size_t x{0}; x < payload.size(); ++x) payload[x] = static_cast<char>('a' + (random() % 26));
+
+		for(const std::uint64_t& count : o.counts)
+		{
+			const boost::filesystem::path folder{o.folder / std::to_string(count)};
+			std::vector<utility::ID_T> sample;
+			std::uint64_t objects{count}; //in the folder right now
+
+			//each row is labelled with the size of the folder when it was measured:
+			auto record = [&results, &objects](result r)
+			{
+				r.count = objects;
+				results.push_back(r);
+			};
+
+			boost::filesystem::remove_all(folder);
+			bench_object::folder() = folder;
+
+			//generate the folder in batches, so that memory stays bounded:
+			for(std::uint64_t made{0}; made < count;)
+			{
+				std::vector<bench_object> batch(std::min<std::uint64_t>(10000, (count - made)));
+				for(bench_object& b : batch) b.name = "object " + std::to_string(made++), b.payload = payload;
+				utility::save_many(batch);
+			}
+			for(std::size_t x{0}; x < o.samples; ++x) sample.push_back(1 + (random() % std::max<std::uint64_t>(count, 1)));
+
+			record(measure("save", "warm", o.samples, 1, [&](const std::size_t&)
+			{
+				bench_object b;
+				b.name = "new";
+				b.payload = payload;
+				utility::save(b);
+			}));
+			objects += o.samples; //the saves made the folder larger for what's measured after them
+
+			evict(folder);
+			record(measure("ids", "cold", 1, objects, [&](const std::size_t&){ utility::ids<bench_object>(); }));
+			record(measure("ids", "warm", o.repeat, objects, [&](const std::size_t&){ utility::ids<bench_object>(); }));
+
+			evict(folder);
+			record(measure("load", "cold", o.samples, 1, [&](const std::size_t& x){ utility::load<bench_object>(sample[x]); }));
+			record(measure("load", "warm", o.samples, 1, [&](const std::size_t& x){ utility::load<bench_object>(sample[x]); }));
+
+			evict(folder);
+			record(measure("load_all", "cold", 1, objects, [&](const std::size_t&){ utility::load_all<bench_object>(); }));
+			record(measure("load_all", "warm", o.repeat, objects, [&](const std::size_t&){ utility::load_all<bench_object>(); }));
+
+			evict(folder);
+			record(measure("load_basic", "cold", 1, objects, [&](const std::size_t&){ utility::load_basic<bench_object>(); }));
+			record(measure("load_basic", "warm", o.repeat, objects, [&](const std::size_t&){ utility::load_basic<bench_object>(); }));
+
+			//remove distinct objects, since removing one twice does nothing:
+			std::sort(sample.begin(), sample.end());
+			sample.erase(std::unique(sample.begin(), sample.end()), sample.end());
+			record(measure("remove", "warm", sample.size(), 1, [&](const std::size_t& x){ utility::remove<bench_object>(sample[x]); }));
+
+			boost::filesystem::remove_all(folder);
+		}
+		boost::filesystem::remove_all(o.folder);
+		print(results, o);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr<< e.what()<< std::endl;
+		return 1;
+	}
+	return 0;
+}
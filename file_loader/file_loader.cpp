@@ -4,239 +4,1842 @@
 #include <set>
 #include <fstream>
 #include <string>
+#include <sstream>
+#include <atomic>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <tuple>
+#include <functional>
+#include <future>
 #include <boost/filesystem.hpp>
+#include <zlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
 #include "file_loader.hpp"
+#include "object_cache.hpp"
+#include "async_io.hpp"
+#include "folder_watcher.hpp"
 #include "filesystem.hpp"
+#include "stream_operations.hpp"
+#include "crc32c.hpp"
 
 namespace
 {
+	std::atomic<bool> sync_enabled{true};
+	thread_local utility::commit_group* active_group{nullptr};
+	
+	void write_file(const boost::filesystem::path&, const std::string&, const bool& = true, const std::function<void()>& = nullptr);
+	void flush(const boost::filesystem::path&, const bool& = false);
+	std::runtime_error io_error(const std::string&, const boost::filesystem::path&);
+	std::string seal(const std::string&);
+	bool verify(const std::string&, std::string::size_type&);
+	bool read_file(const boost::filesystem::path&, std::string&);
+	std::string compress_object(const std::string&, const boost::filesystem::path&);
+	bool is_compressed(const std::string&);
+	std::string decompress_object(const std::string&, const boost::filesystem::path&);
+	std::shared_ptr<const std::string> dictionary(const boost::filesystem::path&);
+	std::unique_ptr<std::istream> open_object(const boost::filesystem::path&, const boost::filesystem::path&);
+	template<typename type> boost::filesystem::path dictionary_file(const boost::filesystem::path&);
+	template<typename type> std::string serialize(const type&);
 	template<typename type> utility::ID_T load_id(const boost::filesystem::path&);
 	template<typename type> type load_basic(const boost::filesystem::path&);
 	template<typename type> type load(const boost::filesystem::path&);
+	template<typename type> type parse(const boost::filesystem::path&, std::string&, const boost::filesystem::path&);
+	template<typename type> boost::filesystem::path id_file(const boost::filesystem::path&);
+	template<typename type> utility::ID_T high_water(const boost::filesystem::path&);
+	template<typename type> void set_high_water(const boost::filesystem::path&, const utility::ID_T&);
+	template<typename type> utility::ID_T allocate_ids(const boost::filesystem::path&, const utility::ID_T& = 1);
+	template<typename type> void make_folder(const boost::filesystem::path&);
+	template<typename type> boost::filesystem::path file_name(const utility::ID_T&, const boost::filesystem::path&);
+	template<typename type> const ::filesystem::pattern& object_pattern();
+	template<typename type> boost::filesystem::path find_file(const utility::ID_T&, const boost::filesystem::path&);
+	template<typename type> std::map<utility::ID_T, boost::filesystem::path> files(const boost::filesystem::path&);
+	template<typename type> std::map<utility::ID_T, boost::filesystem::path> find_files(const std::set<utility::ID_T>&, const boost::filesystem::path&);
+	void share_file(const boost::filesystem::path&, const boost::filesystem::path&);
+	std::map<std::uint64_t, boost::filesystem::path> kept_files(const boost::filesystem::path&);
+	template<typename type> boost::filesystem::path version_folder(const utility::ID_T&, const boost::filesystem::path&);
+	template<typename type> void keep_version(const utility::ID_T&, const boost::filesystem::path&, const boost::filesystem::path&);
+	template<typename type> boost::filesystem::path snapshot_folder(const boost::filesystem::path&);
+	template<typename type> boost::filesystem::path lock_file(const boost::filesystem::path&);
 
 
 
-	template<typename type>
-	inline utility::ID_T load_id(const boost::filesystem::path& file)
+	/*
+	An exclusive advisory lock (flock) on a folder, held while an object is written
+	so that two processes can't give out the same ID or append to the summary cache
+	at the same time.  Loading doesn't take it:  files are only ever replaced by a
+	rename, so a reader sees either the old object or the new one.
+
+	A thread can take the same lock again while it holds it (flock would otherwise
+	block on the second file descriptor), which commit_group relies on.
+	*/
+	class folder_lock
 	{
-		utility::ID_T id;
-		std::ifstream in{file.string().c_str(), std::ios::binary};
-		if(in.good()) id = type::load_id(in);
-		in.close();
-		return id;
+	private:
+		folder_lock(const folder_lock&) = delete;
+		folder_lock(folder_lock&&) = delete;
+		
+		folder_lock& operator=(const folder_lock&) = delete;
+		folder_lock& operator=(folder_lock&&) = delete;
+		
+	public:
+		explicit folder_lock(const boost::filesystem::path&);
+		~folder_lock();
+		
+		static const boost::filesystem::path& innermost();
+		
+	private:
+		static thread_local std::vector<boost::filesystem::path> held; //innermost last
+		
+		int fd;
+		
+	};
+
+	thread_local std::vector<boost::filesystem::path> folder_lock::held{};
+
+	inline std::runtime_error io_error(const std::string& what, const boost::filesystem::path& p)
+	{
+		return std::runtime_error{"Error: " + what + " \"" + p.string() + "\": " + std::string{std::strerror(errno)}};
 	}
 
-	template<typename type>
-	type load(const boost::filesystem::path& p)
+	folder_lock::folder_lock(const boost::filesystem::path& file) : 
+			fd{-1}
 	{
-		type t;
-		std::ifstream in{p.string().c_str(), std::ios::binary};
-		if(in.good()) in>>t;
-		in.close();
-		return t;
+		if(std::find(held.begin(), held.end(), file) == held.end())
+		{
+			this->fd = ::open(file.string().c_str(), (O_RDWR | O_CREAT | O_CLOEXEC), 0666);
+			if(this->fd < 0) throw io_error("unable to open", file);
+			while(::flock(this->fd, LOCK_EX) != 0)
+			{
+				if(errno == EINTR) continue;
+				::close(this->fd);
+				throw io_error("unable to lock", file);
+			}
+		}
+		held.push_back(file);
 	}
 
-	template<typename type>
-	type load_basic(const boost::filesystem::path& p)
+	folder_lock::~folder_lock()
 	{
-		type t;
-		std::ifstream in{p.string().c_str(), std::ios::binary};
-		if(in.good()) t = type::basic(in);
-		in.close();
-		return t;
+		held.pop_back();
+		if(this->fd >= 0) ::close(this->fd);
+	}
+
+	/*
+	The lock file of the most recently taken lock the thread still holds, or an
+	empty path if it holds none.
+	*/
+	const boost::filesystem::path& folder_lock::innermost()
+	{
+		static const boost::filesystem::path none{};
+		return (held.empty() ? none : held.back());
 	}
 
+	/*
+	Writes data to a temporary file ("<file>.<pid>-<n>.tmp") and renames it over file, 
+	flushing according to the current sync setting.  If the thread is in a commit_group 
+	and the write is deferrable, then the temporary file is handed to the group instead
+	of being renamed, along with committed, which the group calls once it's renamed, and
+	the folder lock held for the write, which the group takes again to rename it.
+	*/
+	void write_file(const boost::filesystem::path& file, const std::string& data, const bool& deferrable, const std::function<void()>& committed)
+	{
+		static std::atomic<unsigned long> count{0};
+		boost::filesystem::path temp{file.string() + "." + std::to_string(::getpid()) + "-" + std::to_string(count++) + ".tmp"};
+		bool defer{deferrable && (active_group != nullptr)};
+		int fd{::open(temp.string().c_str(), (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC), 0666)};
 
-}
+		if(fd < 0) throw io_error("unable to create", temp);
+		for(std::string::size_type x{0}; x < data.size();)
+		{
+			ssize_t written{::write(fd, (data.data() + x), (data.size() - x))};
+			if(written < 0)
+			{
+				if(errno == EINTR) continue;
+				::close(fd);
+				throw io_error("unable to write", temp);
+			}
+			x += written;
+		}
+		if(sync_enabled && !defer && (::fsync(fd) != 0))
+		{
+			::close(fd);
+			throw io_error("unable to flush", temp);
+		}
+		if(::close(fd) != 0) throw io_error("unable to write", temp);
+
+		if(defer)
+		{
+			active_group->add(file, temp, folder_lock::innermost(), committed);
+			return;
+		}
+		if(::rename(temp.string().c_str(), file.string().c_str()) != 0) throw io_error("unable to replace", file);
+		if(sync_enabled) flush(file.parent_path());
+	}
 
-namespace utility
-{
 	/*
-	Saves t to its file under "folder".
+	Flushes a file or folder to the disk.  If whole_filesystem is true (and the platform
+	supports it) then everything written to the filesystem containing p is flushed
+	instead, which is how commit_group flushes many files with one call.
+	*/
+	void flush(const boost::filesystem::path& p, const bool& whole_filesystem)
+	{
+		int fd{::open((p.empty() ? std::string{"."} : p.string()).c_str(), (O_RDONLY | O_CLOEXEC))};
+		int result{0};
+
+		if(fd < 0) throw io_error("unable to open", p);
+#ifdef __linux__
+		if(whole_filesystem) result = ::syncfs(fd);
+		else
+#endif
+		result = ::fsync(fd);
+		(void)whole_filesystem;
+		::close(fd);
+		if(result != 0) throw io_error("unable to flush", p);
+	}
+
+	constexpr char CHECKSUM_TAG[4]{'c', 'r', 'c', 'C'};
+	constexpr std::string::size_type TRAILER_SIZE{sizeof(CHECKSUM_TAG) + sizeof(std::uint32_t)};
+
+	/*
+	Appends the checksum trailer to a serialized object:  a tag, followed by the
+	CRC-32C of the object.  It's at the end of the file so that load_id and basic, which
+	only read the beginning, don't have to know about it.
+	*/
+	std::string seal(const std::string& data)
+	{
+		std::string sealed{data};
+		std::uint32_t crc{checksum::crc32c(data)};
+
+		sealed.append(CHECKSUM_TAG, sizeof(CHECKSUM_TAG));
+		sealed.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+		return sealed;
+	}
+
+	/*
+	Checks the trailer of the contents of an object's file.  Returns false if it has
+	one and the checksum doesn't match.  "payload" is set to the size of the object
+	without the trailer.  Files written before checksums were added don't have a
+	trailer, and pass.
+	*/
+	bool verify(const std::string& data, std::string::size_type& payload)
+	{
+		std::uint32_t crc;
+
+		payload = data.size();
+		if((data.size() < TRAILER_SIZE) || (data.compare((data.size() - TRAILER_SIZE), sizeof(CHECKSUM_TAG), CHECKSUM_TAG, sizeof(CHECKSUM_TAG)) != 0)) return true;
+		payload = (data.size() - TRAILER_SIZE);
+		std::memcpy(&crc, (data.data() + data.size() - sizeof(crc)), sizeof(crc));
+		return (checksum::crc32c(data.data(), payload) == crc);
+	}
+
+	bool read_file(const boost::filesystem::path& file, std::string& data)
+	{
+		std::ifstream in{file.string().c_str(), std::ios::binary};
+
+		data.erase();
+		if(!in.good()) return false;
+		in.seekg(0, std::ios::end);
+		data.resize(in.tellg());
+		in.seekg(0, std::ios::beg);
+		in.read(&data[0], data.size());
+		return !in.fail();
+	}
+
+	/*
+	Compressed objects start with this tag, followed by their uncompressed size and
+	a zlib stream.
+	*/
+	constexpr char COMPRESSED_TAG[4]{'z', 'l', 'b', 'C'};
+	constexpr std::string::size_type COMPRESSED_HEADER_SIZE{sizeof(COMPRESSED_TAG) + sizeof(std::uint32_t)};
+
+	/*
+	Detects types that opted into compression with a "static constexpr bool COMPRESS{true};"
+	*/
+	template<typename type, typename = void> struct compressed : std::false_type {};
+	template<typename type> struct compressed<type, typename std::enable_if<type::COMPRESS>::type> : std::true_type {};
+
+	inline bool is_compressed(const std::string& data)
+	{
+		return ((data.size() >= COMPRESSED_HEADER_SIZE) && (data.compare(0, sizeof(COMPRESSED_TAG), COMPRESSED_TAG, sizeof(COMPRESSED_TAG)) == 0));
+	}
+
+	/*
+	The dictionary objects are compressed with.  A copy is kept as "<file>.<adler32>"
+	so that objects compressed with an older dictionary can still be read.
 	*/
 	template<typename type>
-	void save(type& t, const boost::filesystem::path& folder)
+	inline boost::filesystem::path dictionary_file(const boost::filesystem::path& folder)
 	{
-		using boost::filesystem::is_directory;
-		using boost::filesystem::is_regular_file;
-		using boost::filesystem::is_symlink;
-		using boost::filesystem::exists;
-		using boost::filesystem::create_directories;
-		using ::filesystem::glob;
-		using boost::filesystem::path;
+		return (folder / boost::filesystem::path{std::string{type::EXTENSION} + std::string{".dict"}});
+	}
 
-		if(is_symlink(folder)) throw std::runtime_error{"Folder to save file is a symlink!"};
+	/*
+	Returns the contents of a dictionary file, or null if there isn't one.  Dictionaries
+	are kept in memory, and read again only if the file changed:  its inode, size or
+	modification time (to the nanosecond, since it can be trained twice in a second).
+	*/
+	std::shared_ptr<const std::string> dictionary(const boost::filesystem::path& file)
+	{
+		using version = std::tuple<std::uint64_t, std::uint64_t, std::int64_t, std::int64_t>; //inode, size, seconds, nanoseconds
 
-		//create the folder if it doesn't exist:
-		if(!is_directory(folder))
+		static std::mutex m;
+		static std::map<boost::filesystem::path, std::pair<version, std::shared_ptr<const std::string> > > loaded;
+
+		struct stat st;
+
+		if((::stat(file.string().c_str(), &st) != 0) || !S_ISREG(st.st_mode)) return std::shared_ptr<const std::string>{};
+
+		version modified{st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec};
+		std::lock_guard<std::mutex> lock{m};
+		auto it = loaded.find(file);
+
+		if((it == loaded.end()) || (it->second.first != modified))
 		{
-			create_directories(folder);
-			if(!exists(folder)) throw std::runtime_error{"Unable to save!  Couldn't create folder " + folder.string()};
+			std::string data;
+			if(!read_file(file, data)) return std::shared_ptr<const std::string>{};
+			loaded[file] = std::make_pair(modified, std::make_shared<const std::string>(std::move(data)));
+			it = loaded.find(file);
 		}
+		return it->second.second;
+	}
 
-		//assign a new id if there isn't one already:
-		if(t.id == 0)
+	/*
+	Compresses a serialized object with zlib, using the dictionary in dict_file if 
+	there is one.
+	*/
+	std::string compress_object(const std::string& data, const boost::filesystem::path& dict_file)
+	{
+		std::shared_ptr<const std::string> dict{dictionary(dict_file)};
+		std::string out(COMPRESSED_HEADER_SIZE, 0);
+		std::uint32_t size{(std::uint32_t)data.size()};
+		z_stream z;
+
+		if(data.size() > UINT32_MAX) throw std::runtime_error{"Error: object too large to compress"};
+		std::memcpy(&out[0], COMPRESSED_TAG, sizeof(COMPRESSED_TAG));
+		std::memcpy(&out[sizeof(COMPRESSED_TAG)], &size, sizeof(size));
+
+		std::memset(&z, 0, sizeof(z));
+		if(deflateInit(&z, Z_DEFAULT_COMPRESSION) != Z_OK) throw std::runtime_error{"Error: unable to initialize zlib"};
+		if(dict && !dict->empty()) deflateSetDictionary(&z, reinterpret_cast<const Bytef*>(dict->data()), dict->size());
+
+		out.resize(COMPRESSED_HEADER_SIZE + deflateBound(&z, data.size()));
+		z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+		z.avail_in = data.size();
+		z.next_out = reinterpret_cast<Bytef*>(&out[COMPRESSED_HEADER_SIZE]);
+		z.avail_out = (out.size() - COMPRESSED_HEADER_SIZE);
+		if(deflate(&z, Z_FINISH) != Z_STREAM_END)
 		{
-			auto id{ids<type>(folder)};
-			while(id.find(++t.id) != id.end());
+			deflateEnd(&z);
+			throw std::runtime_error{"Error: unable to compress object"};
 		}
-		
-		//now we find its file or create it if it doesn't exist:
-		boost::filesystem::path file;
-		for(glob it{folder, (std::string{"**"} + type::EXTENSION + std::string{"$"}).c_str()}; (!it.end() && !exists(file)); ++it)
+		out.resize(out.size() - z.avail_out);
+		deflateEnd(&z);
+		return out;
+	}
+
+	/*
+	Reverses compress_object().  dict_file is the object's dictionary_file;  the dictionary
+	the object was compressed with is found by its checksum.
+	*/
+	std::string decompress_object(const std::string& data, const boost::filesystem::path& dict_file)
+	{
+		std::uint32_t size;
+		std::string out;
+		z_stream z;
+		int result;
+
+		std::memcpy(&size, (data.data() + sizeof(COMPRESSED_TAG)), sizeof(size));
+		out.resize(size);
+
+		std::memset(&z, 0, sizeof(z));
+		if(inflateInit(&z) != Z_OK) throw std::runtime_error{"Error: unable to initialize zlib"};
+		z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + COMPRESSED_HEADER_SIZE));
+		z.avail_in = (data.size() - COMPRESSED_HEADER_SIZE);
+		z.next_out = reinterpret_cast<Bytef*>(&out[0]);
+		z.avail_out = out.size();
+
+		result = inflate(&z, Z_FINISH);
+		if(result == Z_NEED_DICT)
 		{
-			if(is_regular_file(*it))
+			std::shared_ptr<const std::string> dict{dictionary(dict_file.string() + "." + std::to_string(z.adler))};
+			if(!dict || (inflateSetDictionary(&z, reinterpret_cast<const Bytef*>(dict->data()), dict->size()) != Z_OK))
 			{
-				if(::load_id<type>(it->path()) == t.id)
-				{
-					file = it->path();
-				}
+				inflateEnd(&z);
+				throw std::runtime_error{"Error: missing dictionary " + dict_file.string() + "." + std::to_string(z.adler)};
 			}
+			result = inflate(&z, Z_FINISH);
 		}
+		inflateEnd(&z);
+		if((result != Z_STREAM_END) || (z.avail_out != 0)) throw std::runtime_error{"Error: unable to decompress object"};
+		return out;
+	}
+
+	/*
+	Opens an object's file for load_id and basic.  Uncompressed files are read 
+	directly, so that only the part they need is read.
+	*/
+	std::unique_ptr<std::istream> open_object(const boost::filesystem::path& file, const boost::filesystem::path& dict_file)
+	{
+		std::unique_ptr<std::ifstream> in{new std::ifstream{file.string().c_str(), std::ios::binary}};
+		char tag[sizeof(COMPRESSED_TAG)];
+		std::string data;
+		std::string::size_type payload;
 
-		if(!exists(file))
+		if(!in->good()) return in;
+		if(!in->read(tag, sizeof(tag)) || (std::memcmp(tag, COMPRESSED_TAG, sizeof(tag)) != 0))
 		{
-			file = (folder / path{std::to_string(t.id) + std::string{type::EXTENSION}});
+			in->clear();
+			in->seekg(0, std::ios::beg);
+			return in;
 		}
+		in->close();
+
+		if(!read_file(file, data)) return std::unique_ptr<std::istream>{new std::istringstream{}};
+		verify(data, payload);
+		data.resize(payload);
+		return std::unique_ptr<std::istream>{new std::istringstream{decompress_object(data, dict_file), (std::ios::in | std::ios::binary)}};
+	}
 
-		std::ofstream out{file.string().c_str(), std::ios::binary};
+	template<typename type>
+	inline std::string serialize(const type& t)
+	{
+		std::ostringstream out{std::ios::out | std::ios::binary};
 		out<< t;
-		out.close();
+		if(out.fail()) throw std::runtime_error{"Error: unable to serialize object " + std::to_string(t.id)};
+		return out.str();
+	}
+
+	template<typename type>
+	inline utility::ID_T load_id(const boost::filesystem::path& file)
+	{
+		utility::ID_T id{0};
+		std::unique_ptr<std::istream> in{open_object(file, dictionary_file<type>(file.parent_path()))};
+		if(in->good()) id = type::load_id(*in);
+		return id;
 	}
 
 	/*
-	Loads all ids from files under the specified folder.
+	Loads the object in file p.  A file that can't be read throws, like one that fails
+	its checksum, except that a file that's gone (removed since the folder was listed)
+	gives an object with an ID of 0, which the functions that list a folder skip.
 	*/
 	template<typename type>
-	std::set<ID_T> ids(const boost::filesystem::path& folder)
+	type load(const boost::filesystem::path& p)
 	{
-		using boost::filesystem::is_directory;
-		using boost::filesystem::is_symlink;
-		using boost::filesystem::is_regular_file;
-		using ::filesystem::glob;
+		std::string data;
 
-		std::set<ID_T> i;
-
-		if(!is_directory(folder) || is_symlink(folder)) return i;
-		for(glob it{folder, (std::string{ "**" } +type::EXTENSION + std::string{ "$" }).c_str()}; !it.end(); ++it)
+		if(!read_file(p, data))
 		{
-			if(is_regular_file(*it))
-			{
-				i.insert(load_id<type>(it->path()));
-			}
+			if(!boost::filesystem::exists(p)) return type{};
+			throw std::runtime_error{"Error: unable to read \"" + p.string() + "\""};
 		}
-		return i;
+		return parse<type>(p, data, p.parent_path());
 	}
 
 	/*
-	Loads every object in its entirety.
+	Deserializes the contents of file p, which have already been read into data.  Compressed
+	objects are decompressed with the dictionaries of the given folder.
 	*/
 	template<typename type>
-	std::vector<type> load_all(const boost::filesystem::path& folder)
+	type parse(const boost::filesystem::path& p, std::string& data, const boost::filesystem::path& folder)
+	{
+		type t;
+		std::string::size_type payload;
+
+		if(!verify(data, payload)) throw std::runtime_error{"Error: checksum mismatch in \"" + p.string() + "\""};
+		data.resize(payload);
+		if(is_compressed(data)) data = decompress_object(data, dictionary_file<type>(folder));
+
+		std::istringstream in{data, (std::ios::in | std::ios::binary)};
+		in>> t;
+		return t;
+	}
+
+	template<typename type>
+	type load_basic(const boost::filesystem::path& p)
+	{
+		type t;
+		std::unique_ptr<std::istream> in{open_object(p, dictionary_file<type>(p.parent_path()))};
+		if(in->good()) t = type::basic(*in);
+		return t;
+	}
+
+	/*
+	The file that stores the highest ID ever assigned within a folder.  It's named
+	after the extension so that several types may share a folder, and doesn't end
+	with the extension so it's never mistaken for an object.
+	*/
+	template<typename type>
+	inline boost::filesystem::path id_file(const boost::filesystem::path& folder)
+	{
+		return (folder / boost::filesystem::path{std::string{type::EXTENSION} + std::string{".id"}});
+	}
+
+	/*
+	Returns the highest ID assigned within the folder.  If the folder doesn't
+	have an ID file yet (it was created before IDs were tracked, or the file was
+	lost) then it's rebuilt from the objects themselves, once.
+	*/
+	template<typename type>
+	utility::ID_T high_water(const boost::filesystem::path& folder)
 	{
-		using boost::filesystem::is_directory;
-		using boost::filesystem::is_symlink;
 		using boost::filesystem::is_regular_file;
-		using ::filesystem::glob;
 
-		std::vector<type> t;
+		utility::ID_T hwm{0};
+		boost::filesystem::path file{id_file<type>(folder)};
 
-		if(is_directory(folder) && !is_symlink(folder))
+		if(is_regular_file(file))
 		{
-			for(glob it{folder, (std::string{"**"} + type::EXTENSION + std::string{"$"}).c_str()}; !it.end(); ++it)
-			{
-				if(is_regular_file(it->path()))
-				{
-					t.push_back(::load<type>(it->path()));
-					if(t.back().id == 0) t.pop_back();
-				}
-			}
+			std::ifstream in{file.string().c_str(), std::ios::binary};
+			utility::in_mem<utility::ID_T>(in, hwm);
+			if(!in.fail() && (hwm >= 0)) return hwm;
+			hwm = 0;
 		}
-		return t;
+
+		std::set<utility::ID_T> i{utility::ids<type>(folder)};
+		if(!i.empty()) hwm = *i.rbegin();
+		set_high_water<type>(folder, hwm);
+		return hwm;
+	}
+
+	template<typename type>
+	void set_high_water(const boost::filesystem::path& folder, const utility::ID_T& hwm)
+	{
+		std::ostringstream out{std::ios::out | std::ios::binary};
+		utility::out_mem<utility::ID_T>(out, hwm);
+
+		//never deferred by a commit_group, or another process could hand out the same IDs before it's committed:
+		write_file(id_file<type>(folder), out.str(), false);
 	}
 
 	/*
-	Deletes the file associated with the ID of object t.
+	Reserves "count" consecutive IDs and returns the first one.
 	*/
 	template<typename type>
-	void remove(const ID_T& id, const boost::filesystem::path& folder)
+	utility::ID_T allocate_ids(const boost::filesystem::path& folder, const utility::ID_T& count)
+	{
+		utility::ID_T first{high_water<type>(folder) + 1};
+		set_high_water<type>(folder, (first + count - 1));
+		return first;
+	}
+
+	/*
+	Creates the folder objects are saved to if it doesn't exist.
+	*/
+	template<typename type>
+	void make_folder(const boost::filesystem::path& folder)
 	{
 		using boost::filesystem::is_directory;
 		using boost::filesystem::is_symlink;
-		using ::filesystem::glob;
-		using boost::filesystem::is_regular_file;
-		using boost::filesystem::remove;
 		using boost::filesystem::exists;
+		using boost::filesystem::create_directories;
 
-		if(!is_directory(folder) || is_symlink(folder)) return;
-		for(glob it{folder, (std::string{"**"} + type::EXTENSION + std::string{"$"}).c_str()}; !it.end(); ++it)
+		if(is_symlink(folder)) throw std::runtime_error{"Folder to save file is a symlink!"};
+		if(!is_directory(folder))
 		{
-			if(is_regular_file(*it))
-			{
-				if(load_id<type>(it->path()) == id)
-				{
-					remove(*it);
-					if(exists(*it)) throw std::runtime_error{"Error: could not remove file \"" + it->path().string() + "\""};
-					return;
-				}
-			}
+			create_directories(folder);
+			if(!exists(folder)) throw std::runtime_error{"Unable to save!  Couldn't create folder " + folder.string()};
 		}
 	}
 
 	/*
-	Loads an object from a file given its id.
+	The name given to the file of a newly saved object.
 	*/
 	template<typename type>
-	type load(const ID_T& id, const boost::filesystem::path& folder)
+	inline boost::filesystem::path file_name(const utility::ID_T& id, const boost::filesystem::path& folder)
+	{
+		return (folder / boost::filesystem::path{std::to_string(id) + std::string{type::EXTENSION}});
+	}
+
+	/*
+	Matches the names of the files objects are saved in.
+	*/
+	template<typename type>
+	const ::filesystem::pattern& object_pattern()
+	{
+		static const ::filesystem::pattern objects{std::string{"*"} + type::EXTENSION};
+		return objects;
+	}
+
+	/*
+	Finds the file that stores the object with the given ID.  Objects are
+	normally in the file named after their ID, so that's checked first before
+	falling back to reading the ID of every file in the folder.  Returns an
+	empty path if there's no such object.
+	*/
+	template<typename type>
+	boost::filesystem::path find_file(const utility::ID_T& id, const boost::filesystem::path& folder)
 	{
-		using boost::filesystem::is_directory;
 		using boost::filesystem::is_regular_file;
-		using boost::filesystem::is_symlink;
 		using ::filesystem::glob;
 
-		if(!is_directory(folder) || is_symlink(folder)) throw std::runtime_error{"Error: unable to load from non-existant folder"};
-		for(glob it{folder, (std::string{"**"} + type::EXTENSION + std::string{"$"}).c_str()}; !it.end(); ++it)
+		boost::filesystem::path file{file_name<type>(id, folder)};
+
+		if(is_regular_file(file) && (load_id<type>(file) == id)) return file;
+		for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
 		{
-			if(is_regular_file(*it))
+			if(is_regular_file(it->status()) && (it->path() != file))
 			{
-				if(load_id<type>(it->path()) == id)
-				{
-					return ::load<type>(it->path());
-				}
+				if(load_id<type>(it->path()) == id) return it->path();
 			}
 		}
-		throw std::runtime_error{"Error: attempt to load invalid id!"};
+		return boost::filesystem::path{};
+	}
+
+	template<typename type>
+	inline boost::filesystem::path lock_file(const boost::filesystem::path& folder)
+	{
+		return (folder / boost::filesystem::path{std::string{type::EXTENSION} + std::string{".lock"}});
 	}
 
 	/*
-	Partially loads all objects.
+	Maps every ID in the folder to its file, reading the folder only once.
 	*/
 	template<typename type>
-	std::vector<type> load_basic(const boost::filesystem::path& folder)
+	std::map<utility::ID_T, boost::filesystem::path> files(const boost::filesystem::path& folder)
 	{
 		using boost::filesystem::is_directory;
 		using boost::filesystem::is_symlink;
 		using boost::filesystem::is_regular_file;
 		using ::filesystem::glob;
 
-		std::vector<type> t;
+		std::map<utility::ID_T, boost::filesystem::path> f;
 
-		if(is_directory(folder) && !is_symlink(folder))
+		if(!is_directory(folder) || is_symlink(folder)) return f;
+		for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
 		{
-			for(glob it{ folder, (std::string{ "**" } +type::EXTENSION + std::string{ "$" }).c_str() }; !it.end(); ++it)
-			{
-				if(is_regular_file(it->path()))
-				{
-					t.push_back(::load_basic<type>(it->path()));
-					if(t.back().id == 0) t.pop_back();
-				}
-			}
+			if(is_regular_file(it->status())) f.emplace(load_id<type>(it->path()), it->path());
 		}
-		return t;
+		return f;
 	}
 
+	/*
+	find_file for several IDs:  each is looked for under its own name first, and
+	the folder is read (once) only if some of them aren't there.  IDs without an
+	object are left out of the result.
+	*/
+	template<typename type>
+	std::map<utility::ID_T, boost::filesystem::path> find_files(const std::set<utility::ID_T>& ids, const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_regular_file;
+
+		std::map<utility::ID_T, boost::filesystem::path> f;
+		bool missed{false};
 
+		for(const utility::ID_T& id : ids)
+		{
+			boost::filesystem::path file{file_name<type>(id, folder)};
+			if(is_regular_file(file) && (load_id<type>(file) == id)) f.emplace(id, file);
+			else missed = true;
+		}
+		if(missed)
+		{
+			for(auto& file : ::files<type>(folder))
+			{
+				if((ids.find(file.first) != ids.end()) && (f.find(file.first) == f.end())) f.insert(file);
+			}
+		}
+		return f;
+	}
+
+	/*
+	Gives the file a second name.  Since files are only ever replaced by renaming a new
+	one over them, never modified, a hard link is as good as a copy until the original is
+	replaced.  If the filesystem can't link, it's copied.
+	*/
+	void share_file(const boost::filesystem::path& from, const boost::filesystem::path& to)
+	{
+		boost::system::error_code error;
+
+		boost::filesystem::create_hard_link(from, to, error);
+		if(error) boost::filesystem::copy_file(from, to);
+	}
+
+	/*
+	Maps the number of each version kept in a version folder to its file.
+	*/
+	std::map<std::uint64_t, boost::filesystem::path> kept_files(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using ::filesystem::regular_iterator;
+
+		std::map<std::uint64_t, boost::filesystem::path> kept;
+
+		if(!is_directory(folder)) return kept;
+		for(regular_iterator it{folder}; !it.end(); ++it)
+		{
+			std::string name{it->path().filename().string()};
+			if(!name.empty() && (name.find_first_not_of("0123456789") == std::string::npos)) kept.emplace(std::stoull(name), it->path());
+		}
+		return kept;
+	}
+
+	/*
+	Detects types that keep previous versions of their objects with a
+	"static constexpr std::size_t VERSIONS{n};"
+	*/
+	template<typename type, typename = void> struct kept_versions : std::integral_constant<std::size_t, 0> {};
+	template<typename type> struct kept_versions<type, typename std::enable_if<(type::VERSIONS > 0)>::type> : std::integral_constant<std::size_t, type::VERSIONS> {};
+
+	/*
+	Where the previous versions of an object are kept, numbered in the order they were
+	replaced.
+	*/
+	template<typename type>
+	inline boost::filesystem::path version_folder(const utility::ID_T& id, const boost::filesystem::path& folder)
+	{
+		return (folder / boost::filesystem::path{std::string{type::EXTENSION} + std::string{".versions"}} / boost::filesystem::path{std::to_string(id)});
+	}
+
+	/*
+	Keeps the file an object is about to be replaced in, if its type keeps versions,
+	and removes the oldest versions beyond the number kept.  Must be called with the
+	folder locked.
+	*/
+	template<typename type>
+	void keep_version(const utility::ID_T& id, const boost::filesystem::path& file, const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_regular_file;
+		using boost::filesystem::equivalent;
+		using boost::filesystem::create_directories;
+
+		if((kept_versions<type>::value == 0) || !is_regular_file(file)) return;
+
+		boost::filesystem::path dir{version_folder<type>(id, folder)};
+		std::map<std::uint64_t, boost::filesystem::path> kept{kept_files(dir)};
+
+		//it's already kept if the object was saved twice within a commit_group:
+		if(!kept.empty() && equivalent(kept.rbegin()->second, file)) return;
+
+		create_directories(dir);
+		std::uint64_t next{kept.empty() ? 1 : (kept.rbegin()->first + 1)};
+		share_file(file, (dir / std::to_string(next)));
+		kept.emplace(next, (dir / std::to_string(next)));
+		while(kept.size() > kept_versions<type>::value)
+		{
+			boost::filesystem::remove(kept.begin()->second);
+			kept.erase(kept.begin());
+		}
+	}
+
+	template<typename type>
+	inline boost::filesystem::path snapshot_folder(const boost::filesystem::path& folder)
+	{
+		return (folder / boost::filesystem::path{std::string{type::EXTENSION} + std::string{".snapshots"}});
+	}
+
+
+}
+
+/* Summary cache: */
+namespace
+{
+	/*
+	What the summary cache remembers about a file.  The file, inode, size and modification time
+	identify the version of the file that basic was read from:  if any of them changed the
+	file is read again.
+	*/
+	struct summary_entry
+	{
+		std::uint64_t inode, size;
+		std::int64_t sec, nsec;
+		std::string basic; //the basic() projection, serialized with operator<<
+	};
+
+	bool stamp(const boost::filesystem::path&, summary_entry&);
+	bool same_stamp(const summary_entry&, const summary_entry&);
+	std::map<std::string, summary_entry> read_summary(const boost::filesystem::path&, std::size_t&);
+	void write_summary(const boost::filesystem::path&, const std::map<std::string, summary_entry>&);
+	void append_summary(const boost::filesystem::path&, const std::string&, const summary_entry*);
+	template<typename type> boost::filesystem::path summary_file(const boost::filesystem::path&);
+	template<typename type> std::string summarize(const std::string&);
+	template<typename type> void update_summary(const boost::filesystem::path&, const boost::filesystem::path&, const std::string&);
+	template<typename type> void forget_summary(const boost::filesystem::path&, const boost::filesystem::path&);
+	template<typename type> std::vector<type> cached_basic(const boost::filesystem::path&);
+
+
+
+	/*
+	Fills in the inode, size and modification time of a regular file.  Returns false 
+	if it isn't one.
+	*/
+	bool stamp(const boost::filesystem::path& file, summary_entry& e)
+	{
+		struct stat st;
+
+		if((::stat(file.string().c_str(), &st) != 0) || !S_ISREG(st.st_mode)) return false;
+		e.inode = st.st_ino;
+		e.size = st.st_size;
+		e.sec = st.st_mtim.tv_sec;
+		e.nsec = st.st_mtim.tv_nsec;
+		return true;
+	}
+
+	inline bool same_stamp(const summary_entry& a, const summary_entry& b)
+	{
+		return ((a.inode == b.inode) && (a.size == b.size) && (a.sec == b.sec) && (a.nsec == b.nsec));
+	}
+
+	/*
+	Reads the summary cache.  The cache is a log of records:  either a file's entry, or 
+	a tombstone for a removed file.  Later records replace earlier ones.  A record cut short
+	by a crash ends the log;  everything after it is just read from the object files again.
+	"records" is set to the number of records read so the caller can tell when the log
+	is worth rewriting.
+	*/
+	std::map<std::string, summary_entry> read_summary(const boost::filesystem::path& file, std::size_t& records)
+	{
+		std::map<std::string, summary_entry> entries;
+		std::ifstream in{file.string().c_str(), std::ios::binary};
+
+		records = 0;
+		while(in.good() && (in.peek() != EOF))
+		{
+			char kind{0};
+			std::string name;
+			summary_entry e;
+
+			utility::in_mem<char>(in, kind);
+			utility::read_string(in, name);
+			if(kind == 0)
+			{
+				if(in.fail()) break;
+				entries.erase(name);
+			}
+			else
+			{
+				utility::in_mem<std::uint64_t>(in, e.inode);
+				utility::in_mem<std::uint64_t>(in, e.size);
+				utility::in_mem<std::int64_t>(in, e.sec);
+				utility::in_mem<std::int64_t>(in, e.nsec);
+				utility::read_string(in, e.basic);
+				if(in.fail()) break;
+				entries[name] = e;
+			}
+			++records;
+		}
+		return entries;
+	}
+
+	inline void write_record(std::ostream& out, const std::string& name, const summary_entry* e)
+	{
+		utility::out_mem<char>(out, ((e == nullptr) ? 0 : 1));
+		utility::write_string(out, name);
+		if(e != nullptr)
+		{
+			utility::out_mem<std::uint64_t>(out, e->inode);
+			utility::out_mem<std::uint64_t>(out, e->size);
+			utility::out_mem<std::int64_t>(out, e->sec);
+			utility::out_mem<std::int64_t>(out, e->nsec);
+			utility::write_string(out, e->basic);
+		}
+	}
+
+	/*
+	Rewrites the whole summary cache with one record per file.
+	*/
+	void write_summary(const boost::filesystem::path& file, const std::map<std::string, summary_entry>& entries)
+	{
+		std::ostringstream out{std::ios::out | std::ios::binary};
+
+		for(auto& e : entries) write_record(out, e.first, &(e.second));
+		write_file(file, out.str());
+	}
+
+	/*
+	Adds a single record to the end of the summary cache.  A null entry records
+	the file's removal.
+	*/
+	void append_summary(const boost::filesystem::path& file, const std::string& name, const summary_entry* e)
+	{
+		std::ofstream out{file.string().c_str(), (std::ios::binary | std::ios::app)};
+		write_record(out, name, e);
+	}
+
+	template<typename type>
+	inline boost::filesystem::path summary_file(const boost::filesystem::path& folder)
+	{
+		return (folder / boost::filesystem::path{std::string{type::EXTENSION} + std::string{".summary"}});
+	}
+
+	/*
+	Returns the basic() projection of a serialized object, itself serialized.
+	*/
+	template<typename type>
+	inline std::string summarize(const std::string& data)
+	{
+		std::istringstream in{data, (std::ios::in | std::ios::binary)};
+		return serialize(type::basic(in));
+	}
+
+	/*
+	Called after an object is written to "file", so that the summary cache (if the 
+	folder has one) doesn't have to read it again.  Files waiting in a commit_group
+	aren't in place yet; they'll be picked up by the next load_basic.
+	*/
+	template<typename type>
+	void update_summary(const boost::filesystem::path& folder, const boost::filesystem::path& file, const std::string& data)
+	{
+		boost::filesystem::path cache{summary_file<type>(folder)};
+		summary_entry e;
+
+		if((active_group != nullptr) || !boost::filesystem::is_regular_file(cache)) return;
+		if(!stamp(file, e)) return;
+		e.basic = summarize<type>(data);
+		append_summary(cache, file.filename().string(), &e);
+	}
+
+	template<typename type>
+	void forget_summary(const boost::filesystem::path& folder, const boost::filesystem::path& file)
+	{
+		boost::filesystem::path cache{summary_file<type>(folder)};
+
+		if(boost::filesystem::is_regular_file(cache)) append_summary(cache, file.filename().string(), nullptr);
+	}
+
+	/*
+	load_basic, using the summary cache.  Only files that were changed since they 
+	were summarized are opened.
+	*/
+	template<typename type>
+	std::vector<type> cached_basic(const boost::filesystem::path& folder)
+	{
+		using ::filesystem::glob;
+
+		boost::filesystem::path cache{summary_file<type>(folder)};
+		std::size_t records{0};
+		std::map<std::string, summary_entry> entries{read_summary(cache, records)};
+		std::set<std::string> seen;
+		std::vector<type> t;
+		bool changed{false};
+
+		for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
+		{
+			std::string name{it->path().filename().string()};
+			summary_entry current;
+
+			if(!stamp(it->path(), current)) continue;
+
+			summary_entry& e(entries[name]);
+			if(!same_stamp(e, current) || e.basic.empty())
+			{
+				current.basic = serialize(load_basic<type>(it->path()));
+				e = current;
+				changed = true;
+			}
+			seen.insert(name);
+
+			std::istringstream in{e.basic, (std::ios::in | std::ios::binary)};
+			t.push_back(type::basic(in));
+			if(t.back().id == 0) t.pop_back();
+		}
+
+		for(auto e = entries.begin(); e != entries.end();)
+		{
+			if(seen.find(e->first) == seen.end())
+			{
+				e = entries.erase(e);
+				changed = true;
+			}
+			else ++e;
+		}
+
+		//rewrite the log if it's stale, or if removals and updates have made it much larger than it needs to be:
+		if(changed || (records > (2 * entries.size() + 16))) write_summary(cache, entries);
+		return t;
+	}
+
+
+}
+
+namespace utility
+{
+	/*
+	Saves t to its file under "folder".
+	*/
+	template<typename type>
+	void save(type& t, const boost::filesystem::path& folder)
+	{
+		::make_folder<type>(folder);
+
+		::folder_lock lock{::lock_file<type>(folder)};
+
+		//assign a new id if there isn't one already:
+		bool is_new{t.id == 0};
+		if(is_new) t.id = ::allocate_ids<type>(folder);
+		else if(t.id > ::high_water<type>(folder)) ::set_high_water<type>(folder, t.id);
+		
+		//now we find its file or create it if it doesn't exist (a new ID can't have one, so there's no need to look):
+		boost::filesystem::path file{is_new ? boost::filesystem::path{} : ::find_file<type>(t.id, folder)};
+		if(file.empty()) file = ::file_name<type>(t.id, folder);
+		else ::keep_version<type>(t.id, file, folder);
+
+		//a commit_group only puts the file in place when it's committed, so it erases the cached object again then:
+		std::string data{::serialize(t)};
+		ID_T id{t.id};
+		::write_file(file, ::seal(::compressed<type>::value ? ::compress_object(data, ::dictionary_file<type>(folder)) : data), true, 
+				[folder, id](){ object_cache<type>::get().erase(folder, id); });
+		::update_summary<type>(folder, file, data);
+		object_cache<type>::get().erase(folder, t.id);
+	}
+
+	/*
+	Saves every object in t.  The folder is read at most once, new IDs are assigned
+	together, and all of the files are committed as one group.
+	*/
+	template<typename type>
+	void save_many(std::vector<type>& t, const boost::filesystem::path& folder)
+	{
+		if(t.empty()) return;
+		::make_folder<type>(folder);
+
+		::folder_lock lock{::lock_file<type>(folder)};
+
+		std::set<ID_T> old_ids;
+		ID_T count{0}, highest{0};
+
+		for(const type& object : t)
+		{
+			if(object.id == 0) ++count;
+			else old_ids.insert(object.id);
+			if(object.id > highest) highest = object.id;
+		}
+
+		//only objects that already had an ID can have a file:
+		std::map<ID_T, boost::filesystem::path> existing{::find_files<type>(old_ids, folder)};
+		if(highest > ::high_water<type>(folder)) ::set_high_water<type>(folder, highest);
+		if(count > 0)
+		{
+			ID_T next{::allocate_ids<type>(folder, count)};
+			for(type& object : t)
+			{
+				if(object.id == 0) object.id = next++;
+			}
+		}
+
+		//the group has to be gone before the summary is updated, since the files aren't in place while it's active:
+		std::vector<boost::filesystem::path> written;
+		{
+			commit_group group;
+			for(const type& object : t)
+			{
+				auto file = existing.find(object.id);
+				written.push_back((file == existing.end()) ? ::file_name<type>(object.id, folder) : file->second);
+				if(file != existing.end()) ::keep_version<type>(object.id, file->second, folder);
+				std::string data{::serialize(object)};
+				ID_T id{object.id};
+				::write_file(written.back(), ::seal(::compressed<type>::value ? ::compress_object(data, ::dictionary_file<type>(folder)) : data), true, 
+						[folder, id](){ object_cache<type>::get().erase(folder, id); });
+			}
+			group.commit();
+		}
+
+		if(boost::filesystem::is_regular_file(::summary_file<type>(folder)))
+		{
+			for(std::size_t x{0}; x < t.size(); ++x) ::update_summary<type>(folder, written[x], ::serialize(t[x]));
+		}
+	}
+
+	/*
+	Loads all ids from files under the specified folder.
+	*/
+	template<typename type>
+	std::set<ID_T> ids(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using boost::filesystem::is_regular_file;
+		using ::filesystem::glob;
+
+		std::set<ID_T> i;
+
+		if(!is_directory(folder) || is_symlink(folder)) return i;
+		for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
+		{
+			if(is_regular_file(it->status()))
+			{
+				i.insert(load_id<type>(it->path()));
+			}
+		}
+		return i;
+	}
+
+	/*
+	Loads every object in its entirety.
+	*/
+	template<typename type>
+	std::vector<type> load_all(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using boost::filesystem::is_regular_file;
+		using ::filesystem::glob;
+
+		std::vector<type> t;
+
+		if(is_directory(folder) && !is_symlink(folder))
+		{
+			for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
+			{
+				if(is_regular_file(it->status()))
+				{
+					t.push_back(::load<type>(it->path()));
+					if(t.back().id == 0) t.pop_back();
+				}
+			}
+		}
+		return t;
+	}
+
+	/*
+	Deletes the file associated with the ID of object t.
+	*/
+	template<typename type>
+	void remove(const ID_T& id, const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using boost::filesystem::remove;
+		using boost::filesystem::exists;
+
+		if(!is_directory(folder) || is_symlink(folder)) return;
+
+		//the cache entry goes after the file, so that a load that reads the file before it's gone doesn't get to cache it:
+		::folder_lock lock{::lock_file<type>(folder)};
+		boost::filesystem::path file{::find_file<type>(id, folder)};
+		if(file.empty()) return;
+		remove(file);
+		if(exists(file)) throw std::runtime_error{"Error: could not remove file \"" + file.string() + "\""};
+		object_cache<type>::get().erase(folder, id);
+		::forget_summary<type>(folder, file);
+		boost::filesystem::remove_all(::version_folder<type>(id, folder));
+		if(sync()) ::flush(folder);
+	}
+
+	/*
+	Deletes the files of every ID in id, reading the folder at most once.
+	*/
+	template<typename type>
+	void remove_many(const std::set<ID_T>& id, const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using boost::filesystem::remove;
+		using boost::filesystem::exists;
+
+		if(id.empty() || !is_directory(folder) || is_symlink(folder)) return;
+
+		::folder_lock lock{::lock_file<type>(folder)};
+		for(auto& file : ::find_files<type>(id, folder))
+		{
+			remove(file.second);
+			if(exists(file.second)) throw std::runtime_error{"Error: could not remove file \"" + file.second.string() + "\""};
+			object_cache<type>::get().erase(folder, file.first);
+			::forget_summary<type>(folder, file.second);
+			boost::filesystem::remove_all(::version_folder<type>(file.first, folder));
+		}
+		if(sync()) ::flush(folder);
+	}
+
+	/*
+	Loads an object from a file given its id.
+	*/
+	template<typename type>
+	type load(const ID_T& id, const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+
+		object_cache<type>& cache(object_cache<type>::get());
+		type t;
+
+		if(cache.find(folder, id, t)) return t;
+		if(!is_directory(folder) || is_symlink(folder)) throw std::runtime_error{"Error: unable to load from non-existant folder"};
+
+		//if the object is saved or removed while it's read, the copy read is stale, and isn't cached:
+		std::uint64_t generation{cache.generation(folder, id)};
+		boost::filesystem::path file{::find_file<type>(id, folder)};
+		if(file.empty()) throw std::runtime_error{"Error: attempt to load invalid id!"};
+		t = ::load<type>(file);
+		if(t.id == 0) throw std::runtime_error{"Error: attempt to load invalid id!"};
+		cache.insert(folder, id, t, generation);
+		return t;
+	}
+
+	/*
+	Partially loads all objects.
+	*/
+	template<typename type>
+	std::vector<type> load_basic(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using boost::filesystem::is_regular_file;
+		using ::filesystem::glob;
+
+		std::vector<type> t;
+
+		if(is_directory(folder) && !is_symlink(folder))
+		{
+			if(is_regular_file(::summary_file<type>(folder))) return ::cached_basic<type>(folder);
+			for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
+			{
+				if(is_regular_file(it->status()))
+				{
+					t.push_back(::load_basic<type>(it->path()));
+					if(t.back().id == 0) t.pop_back();
+				}
+			}
+		}
+		return t;
+	}
+
+	/*
+	Gives the folder a summary cache, so that load_basic only opens the files that
+	changed since it was last called.  The cache is stored in the folder (EXTENSION + ".summary")
+	and is kept up to date by save and remove.  Deleting it turns it off.
+	*/
+	template<typename type>
+	void build_summary(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_regular_file;
+
+		::make_folder<type>(folder);
+
+		::folder_lock lock{::lock_file<type>(folder)};
+		if(!is_regular_file(::summary_file<type>(folder))) ::write_summary(::summary_file<type>(folder), std::map<std::string, ::summary_entry>{});
+		::cached_basic<type>(folder);
+	}
+
+	/*
+	Builds a compression dictionary from a sample of the folder's objects, out of the
+	8 byte strings that occur in them most often.  Objects saved afterwards are compressed
+	with it;  objects already saved keep the one they were compressed with.  Only
+	useful for types that opted into compression.
+	*/
+	template<typename type>
+	void train_dictionary(const boost::filesystem::path& folder, const std::size_t& size)
+	{
+		constexpr std::size_t GRAM{8}, SAMPLE_BYTES{8 << 20};
+
+		std::unordered_map<std::uint64_t, std::uint32_t> counts;
+		std::vector<std::pair<std::uint32_t, std::uint64_t> > ranked;
+		std::size_t sampled{0};
+		std::string dict;
+
+		for(load_iterator<type> it{folder}; (!it.end() && (sampled < SAMPLE_BYTES)); ++it)
+		{
+			std::string data{::serialize(*it)};
+			for(std::size_t x{0}; (x + GRAM) <= data.size(); ++x)
+			{
+				std::uint64_t gram;
+				std::memcpy(&gram, (data.data() + x), GRAM);
+				++counts[gram];
+			}
+			sampled += data.size();
+		}
+
+		for(auto& c : counts)
+		{
+			if(c.second > 1) ranked.emplace_back(c.second, c.first);
+		}
+		std::size_t keep{std::min(ranked.size(), (size / GRAM))};
+		std::partial_sort(ranked.begin(), (ranked.begin() + keep), ranked.end(), std::greater<std::pair<std::uint32_t, std::uint64_t> >{});
+		ranked.resize(keep);
+		std::reverse(ranked.begin(), ranked.end());
+
+		//zlib finds matches closest to the end of the dictionary most cheaply, so the most common go last:
+		for(auto& r : ranked) dict.append(reinterpret_cast<const char*>(&r.second), GRAM);
+		if(dict.empty()) return;
+
+		::make_folder<type>(folder);
+
+		::folder_lock lock{::lock_file<type>(folder)};
+		::write_file(boost::filesystem::path{::dictionary_file<type>(folder).string() + "." + std::to_string(adler32(adler32(0, nullptr, 0), reinterpret_cast<const Bytef*>(dict.data()), dict.size()))}, dict);
+		::write_file(::dictionary_file<type>(folder), dict);
+	}
+
+	/*
+	Checks the checksum of every object in the folder, reading the files in parallel,
+	without deserializing any of them.  Returns the files that failed.
+	*/
+	template<typename type>
+	std::vector<boost::filesystem::path> verify_all(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using boost::filesystem::is_regular_file;
+		using ::filesystem::glob;
+
+		std::vector<boost::filesystem::path> files, corrupt;
+		std::atomic<std::size_t> next{0};
+		std::vector<std::thread> workers;
+		std::mutex m;
+
+		if(!is_directory(folder) || is_symlink(folder)) return corrupt;
+		for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
+		{
+			if(is_regular_file(it->status())) files.push_back(it->path());
+		}
+
+		auto check = [&]()
+		{
+			std::string data;
+			std::string::size_type payload;
+
+			for(std::size_t x{next++}; x < files.size(); x = next++)
+			{
+				if(!::read_file(files[x], data) || !::verify(data, payload))
+				{
+					std::lock_guard<std::mutex> lock{m};
+					corrupt.push_back(files[x]);
+				}
+			}
+		};
+		for(unsigned int x{0}; x < std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int)files.size())); ++x) workers.emplace_back(check);
+		for(std::thread& t : workers) t.join();
+		return corrupt;
+	}
+
+	/*
+	Loads an object on one of io_pool's threads.
+	*/
+	template<typename type>
+	std::future<type> async_load(const ID_T& id, const boost::filesystem::path& folder)
+	{
+		return io_pool::get().submit([id, folder](){ return load<type>(id, folder); });
+	}
+
+	/*
+	Saves a copy of t on one of io_pool's threads.  The future holds the ID it was
+	saved with, which is new if t didn't have one.
+	*/
+	template<typename type>
+	std::future<ID_T> async_save(const type& t, const boost::filesystem::path& folder)
+	{
+		return io_pool::get().submit([copy = t, folder]() mutable { save<type>(copy, folder); return copy.id; });
+	}
+
+	/*
+	Loads every object in its entirety, like load_all, but reads the files as one
+	batch with read_files so that the disk is kept busy with many reads at once.
+	*/
+	template<typename type>
+	std::future<std::vector<type> > async_load_all(const boost::filesystem::path& folder)
+	{
+		return io_pool::get().submit([folder]()
+		{
+			using boost::filesystem::is_directory;
+			using boost::filesystem::is_symlink;
+			using boost::filesystem::is_regular_file;
+			using ::filesystem::glob;
+
+			std::vector<boost::filesystem::path> files;
+			std::vector<std::string> data;
+			std::vector<type> t;
+
+			if(!is_directory(folder) || is_symlink(folder)) return t;
+			for(glob it{folder, ::object_pattern<type>()}; !it.end(); ++it)
+			{
+				if(is_regular_file(it->status())) files.push_back(it->path());
+			}
+
+			std::vector<bool> read{read_files(files, data)};
+			for(std::size_t x{0}; x < files.size(); ++x)
+			{
+				if(!read[x])
+				{
+					if(!boost::filesystem::exists(files[x])) continue; //removed since the folder was read
+					throw std::runtime_error{"Error: unable to read \"" + files[x].string() + "\""};
+				}
+				t.push_back(::parse<type>(files[x], data[x], folder));
+				if(t.back().id == 0) t.pop_back();
+				data[x].clear();
+				data[x].shrink_to_fit();
+			}
+			return t;
+		});
+	}
+
+	/*
+	Loads the previous versions kept of an object, newest first.
+	*/
+	template<typename type>
+	std::vector<type> versions(const ID_T& id, const boost::filesystem::path& folder)
+	{
+		std::map<std::uint64_t, boost::filesystem::path> kept{::kept_files(::version_folder<type>(id, folder))};
+		std::vector<type> t;
+
+		for(auto it = kept.rbegin(); it != kept.rend(); ++it)
+		{
+			std::string data;
+			if(::read_file(it->second, data)) t.push_back(::parse<type>(it->second, data, folder));
+		}
+		return t;
+	}
+
+	/*
+	Takes a snapshot of every object in the folder, and returns the folder it's stored
+	in, which can be loaded from like any other.  Files are shared with the folder
+	(hard linked), not copied, so a snapshot costs only a directory entry per object.
+	*/
+	template<typename type>
+	boost::filesystem::path snapshot(const std::string& name, const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using boost::filesystem::is_regular_file;
+		using boost::filesystem::exists;
+		using ::filesystem::regular_iterator;
+
+		const std::string dictionary{::dictionary_file<type>(folder).filename().string()};
+
+		if(!is_directory(folder) || is_symlink(folder)) throw std::runtime_error{"Error: unable to snapshot non-existant folder"};
+		if(name.empty() || (name == ".") || (name == "..") || (name.find('/') != std::string::npos)) throw std::runtime_error{"Error: invalid snapshot name \"" + name + "\""};
+
+		boost::filesystem::path dest{::snapshot_folder<type>(folder) / name}, temp{dest.string() + ".tmp"};
+
+		::folder_lock lock{::lock_file<type>(folder)};
+		if(exists(dest)) throw std::runtime_error{"Error: snapshot \"" + name + "\" already exists"};
+		boost::filesystem::remove_all(temp);
+		boost::filesystem::create_directories(temp);
+
+		//the objects, and the dictionaries needed to decompress them:
+		for(regular_iterator it{folder}; !it.end(); ++it)
+		{
+			std::string file{it->path().filename().string()};
+
+			if((::object_pattern<type>().matches(file) || (file.compare(0, dictionary.size(), dictionary) == 0)) && is_regular_file(it->status())) ::share_file(it->path(), (temp / file));
+		}
+		if(sync()) ::flush(temp);
+		boost::filesystem::rename(temp, dest);
+		if(sync()) ::flush(dest.parent_path());
+		return dest;
+	}
+
+	/*
+	The names of the folder's snapshots.
+	*/
+	template<typename type>
+	std::set<std::string> snapshots(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_directory;
+		using ::filesystem::regular_iterator;
+
+		boost::filesystem::path dir{::snapshot_folder<type>(folder)};
+		std::set<std::string> names;
+
+		if(!is_directory(dir)) return names;
+		for(regular_iterator it{dir}; !it.end(); ++it)
+		{
+			if(is_directory(it->status()) && (it->path().extension() != ".tmp")) names.insert(it->path().filename().string());
+		}
+		return names;
+	}
+
+	template<typename type>
+	void remove_snapshot(const std::string& name, const boost::filesystem::path& folder)
+	{
+		if(name.empty() || (name == ".") || (name == "..") || (name.find('/') != std::string::npos)) return;
+		boost::filesystem::remove_all(::snapshot_folder<type>(folder) / name);
+	}
+
+
+}
+
+/* load_iterator member functions: */
+namespace utility
+{
+	template<typename type>
+	load_iterator<type>::load_iterator() : 
+			it(),
+			current()
+	{
+	}
+
+	template<typename type>
+	load_iterator<type>::load_iterator(const boost::filesystem::path& folder) : 
+			it(),
+			current()
+	{
+		using boost::filesystem::is_directory;
+		using boost::filesystem::is_symlink;
+		using ::filesystem::glob;
+
+		if(!is_directory(folder) || is_symlink(folder)) return;
+		this->it = glob{folder, ::object_pattern<type>()};
+		this->load_current();
+	}
+
+	template<typename type>
+	load_iterator<type>::load_iterator(const load_iterator& l) : 
+			it(l.it),
+			current(l.current)
+	{
+	}
+
+	template<typename type>
+	load_iterator<type>::~load_iterator()
+	{
+	}
+
+	template<typename type>
+	load_iterator<type>& load_iterator<type>::operator=(const load_iterator& l)
+	{
+		if(this != &l)
+		{
+			this->it = l.it;
+			this->current = l.current;
+		}
+		return *this;
+	}
+
+	template<typename type>
+	load_iterator<type>& load_iterator<type>::operator++()
+	{
+		if(this->end()) return *this;
+		++(this->it);
+		this->load_current();
+		return *this;
+	}
+
+	template<typename type>
+	load_iterator<type> load_iterator<type>::operator++(int)
+	{
+		load_iterator<type> l(*this);
+		++(*this);
+		return l;
+	}
+
+	template<typename type>
+	bool load_iterator<type>::operator!=(const load_iterator& l) const
+	{
+		return (this->it != l.it);
+	}
+
+	template<typename type>
+	bool load_iterator<type>::operator==(const load_iterator& l) const
+	{
+		return (this->it == l.it);
+	}
+
+	template<typename type>
+	type& load_iterator<type>::operator*()
+	{
+		return this->current;
+	}
+
+	template<typename type>
+	type* load_iterator<type>::operator->()
+	{
+		return &(this->current);
+	}
+
+	/**
+	 * @return true if there are no more objects.
+	 */
+	template<typename type>
+	bool load_iterator<type>::end() const
+	{
+		return this->it.end();
+	}
+
+	/*
+	Loads the object the glob is on, skipping anything that isn't a valid object.
+	*/
+	template<typename type>
+	void load_iterator<type>::load_current()
+	{
+		using boost::filesystem::is_regular_file;
+
+		for(; !this->it.end(); ++(this->it))
+		{
+			if(is_regular_file(this->it->status()))
+			{
+				this->current = ::load<type>(this->it->path());
+				if(this->current.id != 0) return;
+			}
+		}
+		this->current = type();
+	}
+	
+	
+}
+
+/* folder_watcher member functions: */
+namespace utility
+{
+	template<typename type>
+	folder_watcher<type>::folder_watcher(const std::function<void(const change&, const ID_T&)>& f, const boost::filesystem::path& p) : 
+			base::worker_thread_base(),
+			notify{f},
+			folder{p},
+			known{},
+			fd{-1}
+	{
+		using ::filesystem::regular_iterator;
+
+		this->throttle = 10;
+		::make_folder<type>(this->folder);
+#ifdef __linux__
+		this->fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(this->fd < 0) throw ::io_error("unable to watch", this->folder);
+		if(::inotify_add_watch(this->fd, this->folder.string().c_str(), (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)) < 0)
+		{
+			::close(this->fd);
+			throw ::io_error("unable to watch", this->folder);
+		}
+#else
+		throw std::runtime_error{"Error: folder_watcher requires inotify"};
+#endif
+
+		//the watch is added first, so that nothing saved in the meantime is missed:
+		for(regular_iterator it{this->folder}; !it.end(); ++it)
+		{
+			std::string name{it->path().filename().string()};
+			if(this->is_object(name)) this->known.emplace(name, this->id_of(name));
+		}
+	}
+
+	template<typename type>
+	folder_watcher<type>::~folder_watcher()
+	{
+		if(this->fd >= 0) ::close(this->fd);
+	}
+
+	template<typename type>
+	void folder_watcher<type>::do_work()
+	{
+#ifdef __linux__
+		alignas(inotify_event) char buffer[16384];
+		std::map<std::string, bool> touched; //file name -> whether it exists after the last event
+		bool overflow{false};
+		ssize_t size;
+
+		while((size = ::read(this->fd, buffer, sizeof(buffer))) > 0)
+		{
+			for(char* p{buffer}; p < (buffer + size);)
+			{
+				const inotify_event* e{reinterpret_cast<const inotify_event*>(p)};
+
+				if(e->mask & IN_Q_OVERFLOW) overflow = true;
+				else if((e->len > 0) && this->is_object(e->name)) touched[e->name] = ((e->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0);
+				p += (sizeof(inotify_event) + e->len);
+			}
+		}
+		if(overflow) this->rescan(touched);
+
+		for(auto& t : touched)
+		{
+			auto previous = this->known.find(t.first);
+			ID_T id{t.second ? this->id_of(t.first) : 0};
+
+			if(id != 0)
+			{
+				this->known[t.first] = id;
+				this->notify(((previous == this->known.end()) ? change::added : change::updated), id);
+			}
+			else if(previous != this->known.end())
+			{
+				id = previous->second;
+				this->known.erase(previous);
+				this->notify(change::removed, id);
+			}
+		}
+#endif
+	}
+
+	template<typename type>
+	bool folder_watcher<type>::is_object(const std::string& name) const
+	{
+		return ((name.size() > std::strlen(type::EXTENSION)) && ::object_pattern<type>().matches(name));
+	}
+
+	/*
+	Objects are named after their ID, so it's taken from the name if it can be.
+	Returns 0 if the file can't be read.
+	*/
+	template<typename type>
+	ID_T folder_watcher<type>::id_of(const std::string& name) const
+	{
+		const std::string stem{name.substr(0, (name.size() - std::strlen(type::EXTENSION)))};
+
+		if(!stem.empty() && (stem.size() < 19) && (stem.find_first_not_of("0123456789") == std::string::npos) && (stem[0] != '0'))
+		{
+			return (boost::filesystem::is_regular_file(this->folder / name) ? std::stoll(stem) : 0);
+		}
+		return ::load_id<type>(this->folder / name);
+	}
+
+	/*
+	Marks every object in the folder as touched, and every known object that's not
+	there anymore as removed.
+	*/
+	template<typename type>
+	void folder_watcher<type>::rescan(std::map<std::string, bool>& touched) const
+	{
+		using ::filesystem::regular_iterator;
+
+		for(auto& k : this->known) touched[k.first] = false;
+		for(regular_iterator it{this->folder}; !it.end(); ++it)
+		{
+			std::string name{it->path().filename().string()};
+			if(this->is_object(name)) touched[name] = true;
+		}
+	}
+	
+	
+}
+
+/* Durability settings: */
+namespace utility
+{
+	/*
+	If true (the default), each save is flushed to the disk before it replaces
+	the old object.
+	*/
+	void set_sync(const bool& s)
+	{
+		sync_enabled = s;
+	}
+
+	bool sync()
+	{
+		return sync_enabled;
+	}
+	
+	
+}
+
+/* commit_group member functions: */
+namespace utility
+{
+	commit_group::commit_group() : 
+			pending{},
+			outer{active_group}
+	{
+		active_group = this;
+	}
+
+	/*
+	Commits whatever wasn't committed.  A destructor can't throw, so errors are
+	ignored here;  call commit() to have them reported.  Temporary files that
+	couldn't be renamed are left for the next save of the object to replace.
+	*/
+	commit_group::~commit_group()
+	{
+		try
+		{
+			this->commit();
+		}
+		catch(...)
+		{
+		}
+		active_group = this->outer;
+	}
+
+	/*
+	Flushes every pending file, renames them into place, and then flushes each folder
+	once.  The renames are made holding the lock of every folder they were written
+	under, so that they're atomic to other writers and to snapshot().  A group nested
+	within another passes its files to the outer group instead.
+	*/
+	void commit_group::commit()
+	{
+		std::set<boost::filesystem::path> folders;
+
+		if(this->outer != nullptr)
+		{
+			for(auto& p : this->pending) this->outer->add(p.first, p.second.temp, p.second.lock, p.second.committed);
+			this->pending.clear();
+			return;
+		}
+
+		if(sync_enabled)
+		{
+			//on Linux, syncfs() writes out everything on the filesystem in one call, so only one is needed per device:
+#ifdef __linux__
+			std::set<dev_t> devices;
+#endif
+			for(auto& p : this->pending)
+			{
+#ifdef __linux__
+				struct stat st;
+				if(::stat(p.second.temp.string().c_str(), &st) != 0) throw io_error("unable to stat", p.second.temp);
+				if(devices.insert(st.st_dev).second) flush(p.second.temp, true);
+#else
+				flush(p.second.temp);
+#endif
+			}
+		}
+
+		{
+			//always taken in the same (sorted) order, so that two groups can't deadlock:
+			std::set<boost::filesystem::path> lock_files;
+			std::vector<std::unique_ptr<folder_lock> > locks;
+
+			for(auto& p : this->pending)
+			{
+				if(!p.second.lock.empty()) lock_files.insert(p.second.lock);
+			}
+			for(const boost::filesystem::path& l : lock_files) locks.emplace_back(new folder_lock{l});
+
+			for(auto it = this->pending.begin(); it != this->pending.end(); it = this->pending.erase(it))
+			{
+				if(::rename(it->second.temp.string().c_str(), it->first.string().c_str()) != 0) throw io_error("unable to replace", it->first);
+				if(it->second.committed) it->second.committed();
+				folders.insert(it->first.parent_path());
+			}
+		}
+		if(sync_enabled)
+		{
+			for(const boost::filesystem::path& folder : folders) flush(folder);
+		}
+	}
+
+	/*
+	The innermost group the calling thread is in, or null if it isn't in one.
+	*/
+	commit_group* commit_group::active()
+	{
+		return active_group;
+	}
+
+	/*
+	Adds a temporary file to be renamed over dest when the group is committed, under
+	the folder lock lock (if it isn't empty).  committed, if there is one, is called
+	after the rename.
+	*/
+	void commit_group::add(const boost::filesystem::path& dest, const boost::filesystem::path& temp, const boost::filesystem::path& lock, const std::function<void()>& committed)
+	{
+		auto it = this->pending.find(dest);
+
+		//the object was saved again, so its older temporary file won't be needed:
+		if(it != this->pending.end())
+		{
+			boost::system::error_code ec;
+			boost::filesystem::remove(it->second.temp, ec);
+			it->second = pending_file{temp, lock, committed};
+		}
+		else this->pending[dest] = pending_file{temp, lock, committed};
+	}
+	
+	
 }
 
 namespace utility
@@ -245,8 +1848,22 @@ namespace utility
 	template std::set<ID_T>                  ids       <type>(const boost::filesystem::path& folder);
 	template std::vector<data::account_data> load_all  <type>(const boost::filesystem::path& folder);
 	template void                            remove    <type>(const ID_T& id, const boost::filesystem::path& folder);
+	template void                            save_many <type>(std::vector<data::account_data>& t, const boost::filesystem::path& folder);
+	template void                            remove_many<type>(const std::set<ID_T>& id, const boost::filesystem::path& folder);
 	template data::account_data              load      <type>(const ID_T& id, const boost::filesystem::path& folder);
-	template std::vector<data::account_data> load_basic<type>(const boost::filesystem::path& folder);*/
+	template std::vector<data::account_data> load_basic<type>(const boost::filesystem::path& folder);
+	template void                            build_summary<type>(const boost::filesystem::path& folder);
+	template std::vector<boost::filesystem::path> verify_all<type>(const boost::filesystem::path& folder);
+	template void                            train_dictionary<type>(const boost::filesystem::path& folder, const std::size_t& size);
+	template std::future<data::account_data> async_load<type>(const ID_T& id, const boost::filesystem::path& folder);
+	template std::future<ID_T>               async_save<type>(const data::account_data& t, const boost::filesystem::path& folder);
+	template std::future<std::vector<data::account_data> > async_load_all<type>(const boost::filesystem::path& folder);
+	template std::vector<data::account_data> versions<type>(const ID_T& id, const boost::filesystem::path& folder);
+	template boost::filesystem::path         snapshot<type>(const std::string& name, const boost::filesystem::path& folder);
+	template std::set<std::string>           snapshots<type>(const boost::filesystem::path& folder);
+	template void                            remove_snapshot<type>(const std::string& name, const boost::filesystem::path& folder);
+	template class                           load_iterator<data::account_data>;
+	template class                           folder_watcher<data::account_data>;*/
 
 }
 
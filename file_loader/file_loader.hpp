@@ -1,5 +1,5 @@
 /**
-requires filesystem abstraction I wrote.
+requires filesystem abstraction I wrote, worker_thread_base (for folder_watcher), and zlib.
 
 Loading and saving functions for arbitrary objects.  Based on a model where 
 a list of objects is saved within a folder.  The functions declared below require
@@ -21,6 +21,10 @@ explicit template instantiation for use.
 
 	Those are the minumum required member variables.
 
+	Instead of writing load_id, basic, operator<< and operator>> by hand, a type can
+	list its members and derive from utility::schema (see schema.hpp), which generates
+	them.
+
 Storage model:
 	The way this works is that each object is saved into a file under a folder.  So,
 	the objects can be represented as both files or data structures.  Given an
@@ -55,7 +59,10 @@ Explanation of member variables/functions:
 	-  utility::ID_T id;
 			Specifies the unique ID assigned to the object.  This
 			is used to associate the object with its file, and isn't
-			assigned until the object is saved.
+			assigned until the object is saved.  New IDs are handed out
+			from a high-water mark stored next to the objects (a file named
+			EXTENSION + ".id"), so assigning one doesn't require reading every
+			object in the folder.  IDs are never reused once removed.
 
 	-  static type basic(std::istream&);
 			Privide this function in order to use the load_basic function.
@@ -66,17 +73,127 @@ Explanation of member variables/functions:
 			is just load the whole object when needed using its ID.  Use this method of
 			loading if you think memory will be a problem.  Otherwise, you can just load
 			everything.
+
+			build_summary() gives a folder a cache of every object's basic information,
+			so that load_basic only has to read the files that changed.  summary_index.hpp
+			sorts and filters those summaries by a key of your choosing.
+
+Loading lazily:
+	load_all() and load_basic() return every object at once.  If that's too much memory,
+	load_iterator loads one object at a time as it's incremented, and the loop can stop
+	whenever it wants to:
+
+		for(utility::load_iterator<type_t> it{type_t::folder()}; !it.end(); ++it)
+		{
+			if(it->id == wanted) break;
+		}
+
+	Like the functions, it requires explicit instantiation:  template class utility::load_iterator<type_t>;
+
+Compression:
+	A type can have its objects compressed (with zlib) by declaring
+
+		static constexpr bool COMPRESS{true};
+
+	Compressed files are decompressed by every load function, so a folder may contain
+	both.  Because many small objects don't compress well on their own, train_dictionary()
+	builds a dictionary from the folder's objects (stored as EXTENSION + ".dict") that
+	later saves compress against.  Old dictionaries are kept, named by their checksum,
+	for the objects that were compressed with them.
+
+Asynchronous loading:
+	async_load, async_save and async_load_all do the same as their blocking counterparts
+	on a shared pool of threads (io_pool, in async_io.hpp), and return a std::future for
+	the result.  Exceptions are rethrown by the future's get().  async_save saves a copy
+	of the object, so the future holds the ID it was given.  async_load_all reads the
+	whole folder as a single batch:  on Linux the reads are submitted together through
+	io_uring, and elsewhere (or if the kernel doesn't allow it) they're read one by one.
+
+Versions and snapshots:
+	A type can keep the previous versions of its objects by declaring
+
+		static constexpr std::size_t VERSIONS{3};
+
+	Each save keeps the file being replaced (under EXTENSION + ".versions"), and the oldest
+	are removed once there are more than VERSIONS of them.  versions() loads them, newest
+	first.  Removing an object removes its versions.
+
+	snapshot() takes a consistent copy of the whole folder under a name, and returns the
+	folder it's in (EXTENSION + ".snapshots/<name>"), which can be passed to load_all, load,
+	load_iterator, etc. like any other.  Objects aren't copied:  because files are never
+	modified, only replaced, the snapshot holds hard links to them, and an object only takes
+	more space once it's saved again.  Snapshots last until remove_snapshot() is called.
+	Saves, and the renames of a committing commit_group, are locked out while the snapshot
+	is taken, so it has either all of a group's objects in the folder or none of them.
+
+Watching for changes:
+	folder_watcher.hpp calls a function when objects are added, updated or removed,
+	including by other processes, so that a folder doesn't have to be polled.
+
+Log-structured storage:
+	log_store.hpp stores objects as appends to a log instead of one file each, for
+	folders that are saved to much more often than they're read by other programs.
+
+Caching:
+	object_cache.hpp holds an optional LRU cache of the objects returned by load().
+	It's off by default; see object_cache for how to turn it on.
+
+Durability:
+	Objects are never overwritten in place.  save() writes the object to a temporary
+	file next to its destination ("<file>.<pid>-<n>.tmp"), flushes it to the disk, and
+	then renames it over the old file.  A crash will leave either the old object or the
+	new one, never a mix of the two.  Flushing can be turned off with set_sync(false) if
+	you don't care about losing the most recent saves on power loss (the rename is still
+	atomic).
+
+	Flushing every object is expensive when saving a lot of them, so a commit_group can
+	be used to batch them:
+
+		{
+			utility::commit_group group;
+			for(auto& t : objects) utility::save(t);
+			group.commit();
+		}
+
+	Saves made by the thread while the group exists are written to their temporary files
+	only.  commit() flushes them all at once, renames them into place and flushes each
+	folder once, holding each folder's lock while it renames.  Until then, the saves are
+	not visible to loads.  If commit() isn't called, the destructor does it, but errors
+	can only be reported by commit().
+
+Sharing a folder:
+	Several threads or processes may load from and save to the same folder.  Functions
+	that write take an exclusive lock (flock on EXTENSION + ".lock") for the duration of
+	the write, so IDs are never handed out twice.  Functions that only read don't lock:
+	since a file is only ever replaced by renaming a new one over it, a reader sees either
+	the old object or the new one.  Saves within a commit_group reserve their IDs right
+	away, but aren't visible to other processes until they're committed.
+
+Integrity:
+	save() ends every file with a checksum (a 4 byte tag and the CRC-32C of the object).
+	load(), load_all() and load_iterator throw a runtime_error if an object doesn't match
+	its checksum, instead of returning whatever could be read.  verify_all() checks a
+	whole folder without deserializing anything.  load_id and basic read only the beginning
+	of the file, so they don't check it.  Files saved before checksums were added are
+	loaded as they were.
 */
 
 #ifndef UTILITY_FILE_LOADER_HPP_INCLUDED
 #define UTILITY_FILE_LOADER_HPP_INCLUDED
 #include <boost/filesystem.hpp>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
 #include <set>
+#include <string>
 #include <vector>
 
+#include "filesystem.hpp"
+
 namespace utility
 {
-	using ID_T = int_least16_t;
+	using ID_T = std::int_least64_t;
 	
 	template<typename type> void              save(type&, const boost::filesystem::path& = type::folder());
 	template<typename type> std::set<ID_T>    ids(const boost::filesystem::path& = type::folder());
@@ -84,6 +201,97 @@ namespace utility
 	template<typename type> std::vector<type> load_basic(const boost::filesystem::path& = type::folder());
 	template<typename type> type              load(const ID_T&, const boost::filesystem::path& = type::folder());
 	template<typename type> void              remove(const ID_T&, const boost::filesystem::path& = type::folder());
+	template<typename type> void              save_many(std::vector<type>&, const boost::filesystem::path& = type::folder());
+	template<typename type> void              remove_many(const std::set<ID_T>&, const boost::filesystem::path& = type::folder());
+	template<typename type> void              build_summary(const boost::filesystem::path& = type::folder());
+	template<typename type> std::vector<boost::filesystem::path> verify_all(const boost::filesystem::path& = type::folder());
+	template<typename type> void              train_dictionary(const boost::filesystem::path& = type::folder(), const std::size_t& = 32768);
+	
+	template<typename type> std::future<type>              async_load(const ID_T&, const boost::filesystem::path& = type::folder());
+	template<typename type> std::future<ID_T>              async_save(const type&, const boost::filesystem::path& = type::folder());
+	template<typename type> std::future<std::vector<type> > async_load_all(const boost::filesystem::path& = type::folder());
+	
+	template<typename type> std::vector<type>              versions(const ID_T&, const boost::filesystem::path& = type::folder());
+	template<typename type> boost::filesystem::path        snapshot(const std::string&, const boost::filesystem::path& = type::folder());
+	template<typename type> std::set<std::string>          snapshots(const boost::filesystem::path& = type::folder());
+	template<typename type> void                           remove_snapshot(const std::string&, const boost::filesystem::path& = type::folder());
+
+	/**
+	 * @class load_iterator
+	 * @brief An input iterator that loads each object within a folder
+	 * as it's reached, holding only one in memory at a time.
+	 */
+	template<typename type>
+	class load_iterator
+	{
+	public:
+		explicit load_iterator();
+		load_iterator(const boost::filesystem::path&);
+		load_iterator(const load_iterator&);
+		
+		~load_iterator();
+		
+		load_iterator& operator=(const load_iterator&);
+		load_iterator& operator++();
+		load_iterator operator++(int);
+		
+		bool operator!=(const load_iterator&) const;
+		bool operator==(const load_iterator&) const;
+		
+		type& operator*();
+		type* operator->();
+		
+		bool end() const;
+		
+	private:
+		void load_current();
+		
+		::filesystem::glob it;
+		type current;
+		
+	};
+	
+	void set_sync(const bool&);
+	bool sync();
+	
+	/**
+	 * @class commit_group
+	 * @brief Defers the saves made by the current thread until commit() is
+	 * called, so that they can be flushed to the disk together.  If commit()
+	 * isn't called, the destructor commits, and ignores any error.
+	 * 
+	 * This is non-copyable, and non-movable.
+	 */
+	class commit_group
+	{
+	private:
+		commit_group(const commit_group&) = delete;
+		commit_group(commit_group&&) = delete;
+		
+		commit_group& operator=(const commit_group&) = delete;
+		commit_group& operator=(commit_group&&) = delete;
+		
+	public:
+		explicit commit_group();
+		~commit_group();
+		
+		void commit();
+		void add(const boost::filesystem::path&, const boost::filesystem::path&, const boost::filesystem::path& = boost::filesystem::path{}, const std::function<void()>& = nullptr);
+		
+		static commit_group* active();
+		
+	private:
+		struct pending_file
+		{
+			boost::filesystem::path temp;
+			boost::filesystem::path lock; //the folder lock to hold while it's renamed
+			std::function<void()> committed; //called once the file is in place
+		};
+		
+		std::map<boost::filesystem::path, pending_file> pending; //destination -> temporary file
+		commit_group* outer;
+		
+	};
 
 }
 
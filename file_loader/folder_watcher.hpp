@@ -0,0 +1,66 @@
+#ifndef UTILITY_FOLDER_WATCHER_HPP_INCLUDED
+#define UTILITY_FOLDER_WATCHER_HPP_INCLUDED
+#include <boost/filesystem.hpp>
+#include <functional>
+#include <map>
+#include <string>
+
+#include "file_loader.hpp"
+#include "worker_thread_base.hpp"
+
+namespace utility
+{
+	enum class change
+	{
+		added,
+		updated,
+		removed
+	};
+
+	/**
+	 * @class folder_watcher
+	 * @file folder_watcher.hpp
+	 * @brief Calls a function whenever an object in a folder is added, updated or
+	 * removed, by this process or any other.  It's backed by inotify, so it's only
+	 * available on Linux; elsewhere the constructor throws.
+	 *
+	 * Changes are collected between calls of do_work (10 times per second), and
+	 * coalesced by object:  an object saved several times is reported as updated
+	 * once, and an object added and removed again isn't reported at all.  If the
+	 * kernel drops events (its queue overflowed), the folder is read again, and
+	 * every object in it is reported as updated.
+	 *
+	 * utility::folder_watcher<type_t> watcher{[](const utility::change& c, const utility::ID_T& id){ ... }};
+	 * watcher.start();
+	 * ...
+	 * watcher.halt();
+	 *
+	 * The function is called on the watcher's thread.  Like the functions in
+	 * file_loader.hpp, it requires explicit instantiation:  template class utility::folder_watcher<type_t>;
+	 */
+	template<typename type>
+	class folder_watcher : public base::worker_thread_base
+	{
+	public:
+		explicit folder_watcher(const std::function<void(const change&, const ID_T&)>&, const boost::filesystem::path& = type::folder());
+		virtual ~folder_watcher();
+
+	protected:
+		virtual void do_work();
+
+	private:
+		bool is_object(const std::string&) const;
+		ID_T id_of(const std::string&) const;
+		void rescan(std::map<std::string, bool>&) const;
+
+		std::function<void(const change&, const ID_T&)> notify;
+		boost::filesystem::path folder;
+		std::map<std::string, ID_T> known; //file name -> ID of every object in the folder
+		int fd;
+
+	};
+
+
+}
+
+#endif
@@ -0,0 +1,604 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#include "log_store.hpp"
+#include "filesystem.hpp"
+
+namespace
+{
+	enum record_kind : char
+	{
+		removed = 0,
+		object,
+		high_water, //the highest ID handed out, written at the start of a compacted segment
+		supersedes //marks a compacted segment:  every segment numbered lower is obsolete
+	};
+
+	constexpr std::uint64_t HEADER_SIZE{1 + sizeof(std::int64_t) + sizeof(std::uint32_t)};
+
+	std::runtime_error io_error(const std::string&, const boost::filesystem::path&);
+	std::string header(const char&, const utility::ID_T&, const std::uint64_t&);
+	bool parse_header(const char*, char&, utility::ID_T&, std::uint64_t&);
+	void write_all(const int&, const std::string&, const boost::filesystem::path&);
+	bool read_all(const int&, std::string&, const std::uint64_t&, const std::uint64_t&);
+	void flush_fd(const int&, const boost::filesystem::path&);
+	std::map<std::uint64_t, boost::filesystem::path> list_segments(const boost::filesystem::path&);
+
+
+
+	inline std::runtime_error io_error(const std::string& what, const boost::filesystem::path& p)
+	{
+		return std::runtime_error{"Error: " + what + " \"" + p.string() + "\": " + std::string{std::strerror(errno)}};
+	}
+
+	inline std::string header(const char& kind, const utility::ID_T& id, const std::uint64_t& length)
+	{
+		std::string h(HEADER_SIZE, 0);
+		std::int64_t i{id};
+		std::uint32_t l{(std::uint32_t)length};
+
+		if(length > UINT32_MAX) throw std::runtime_error{"Error: object " + std::to_string(id) + " is too large for a log_store"};
+		h[0] = kind;
+		std::memcpy(&h[1], &i, sizeof(i));
+		std::memcpy(&h[1 + sizeof(i)], &l, sizeof(l));
+		return h;
+	}
+
+	inline bool parse_header(const char* h, char& kind, utility::ID_T& id, std::uint64_t& length)
+	{
+		std::int64_t i;
+		std::uint32_t l;
+
+		kind = h[0];
+		std::memcpy(&i, (h + 1), sizeof(i));
+		std::memcpy(&l, (h + 1 + sizeof(i)), sizeof(l));
+		id = i;
+		length = l;
+		return ((kind >= removed) && (kind <= supersedes));
+	}
+
+	void write_all(const int& fd, const std::string& data, const boost::filesystem::path& p)
+	{
+		for(std::string::size_type x{0}; x < data.size();)
+		{
+			ssize_t written{::write(fd, (data.data() + x), (data.size() - x))};
+			if(written < 0)
+			{
+				if(errno == EINTR) continue;
+				throw io_error("unable to write", p);
+			}
+			x += written;
+		}
+	}
+
+	/*
+	Reads exactly "length" bytes at "offset".  Returns false if the file is too short.
+	*/
+	bool read_all(const int& fd, std::string& data, const std::uint64_t& offset, const std::uint64_t& length)
+	{
+		data.resize(length);
+		for(std::uint64_t x{0}; x < length;)
+		{
+			ssize_t r{::pread(fd, (&data[0] + x), (length - x), (offset + x))};
+			if(r < 0)
+			{
+				if(errno == EINTR) continue;
+				return false;
+			}
+			if(r == 0) return false;
+			x += r;
+		}
+		return true;
+	}
+
+	inline void flush_fd(const int& fd, const boost::filesystem::path& p)
+	{
+		if(utility::sync() && (::fsync(fd) != 0)) throw io_error("unable to flush", p);
+	}
+
+	/*
+	Returns every "<n>.log" file in the folder, in order.
+	*/
+	std::map<std::uint64_t, boost::filesystem::path> list_segments(const boost::filesystem::path& folder)
+	{
+		using boost::filesystem::is_regular_file;
+
+		std::map<std::uint64_t, boost::filesystem::path> s;
+
+		for(filesystem::regular_iterator it{folder}; !it.end(); ++it)
+		{
+			const boost::filesystem::path& p(it->path());
+			std::string stem{p.stem().string()};
+
+			if((p.extension() != ".log") || stem.empty() || !is_regular_file(p)) continue;
+			if(!std::all_of(stem.begin(), stem.end(), [](const char& c){ return ((c >= '0') && (c <= '9')); })) continue;
+			s[std::stoull(stem)] = p;
+		}
+		return s;
+	}
+
+
+}
+
+/* log_store member functions: */
+namespace utility
+{
+	/**
+	 * @param f The folder to keep the segments in.  It's created if it doesn't exist.
+	 * @param b How many bytes to buffer before writing them to the active segment.
+	 * @param s How large a segment can get before a new one is started.
+	 */
+	log_store::log_store(const boost::filesystem::path& f, const std::size_t& b, const std::uint64_t& s) :
+			folder{f},
+			buffer_size{b},
+			segment_size{s},
+			m{},
+			compacting{},
+			index{},
+			segments{},
+			active{1},
+			active_size{0},
+			active_fd{-1},
+			buffer{},
+			live_bytes{0},
+			total_bytes{0},
+			hwm{0},
+			lock_fd{-1}
+	{
+		boost::filesystem::path lock{this->folder / "lock"};
+
+		if(!boost::filesystem::is_directory(this->folder)) boost::filesystem::create_directories(this->folder);
+		this->lock_fd = ::open(lock.string().c_str(), (O_RDWR | O_CREAT | O_CLOEXEC), 0666);
+		if(this->lock_fd < 0) throw io_error("unable to open", lock);
+		if(::flock(this->lock_fd, (LOCK_EX | LOCK_NB)) != 0)
+		{
+			::close(this->lock_fd);
+			throw std::runtime_error{"Error: " + this->folder.string() + " is already open by another log_store"};
+		}
+		try
+		{
+			this->open();
+		}
+		catch(...)
+		{
+			for(auto& s : this->segments) ::close(s.second);
+			if(this->active_fd >= 0) ::close(this->active_fd);
+			::close(this->lock_fd);
+			throw;
+		}
+	}
+
+	/**
+	 * @brief Writes out the buffer and closes the segments.  Errors writing the
+	 * buffer are ignored, since a destructor can't throw;  call flush() first to
+	 * have them reported.
+	 */
+	log_store::~log_store()
+	{
+		try
+		{
+			this->flush();
+		}
+		catch(...)
+		{
+		}
+		if(this->active_fd >= 0) ::close(this->active_fd);
+		for(auto& s : this->segments) ::close(s.second);
+		::close(this->lock_fd);
+	}
+
+	void log_store::put(const ID_T& id, const std::string& data)
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+
+		if(id <= 0) throw std::runtime_error{"Error: invalid id " + std::to_string(id)};
+		this->append(object, id, data);
+	}
+
+	/**
+	 * @brief Copies the newest version of the object into data.
+	 * @return false if there isn't one.
+	 */
+	bool log_store::get(const ID_T& id, std::string& data)
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+		auto it = this->index.find(id);
+
+		if(it == this->index.end()) return false;
+		return this->read(it->second, data);
+	}
+
+	void log_store::remove(const ID_T& id)
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+
+		if(this->index.find(id) == this->index.end()) return;
+		this->append(removed, id, std::string{});
+	}
+
+	std::set<ID_T> log_store::ids()
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+		std::set<ID_T> i;
+
+		for(auto& e : this->index) i.insert(e.first);
+		return i;
+	}
+
+	/**
+	 * @brief Reserves a new ID.  IDs are never reused.
+	 */
+	ID_T log_store::next_id()
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+		return ++(this->hwm);
+	}
+
+	/**
+	 * @brief Writes the buffer to the active segment.
+	 */
+	void log_store::flush()
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+		this->write_buffer();
+	}
+
+	/**
+	 * @return The fraction of the log taken by objects that were replaced or removed.
+	 */
+	double log_store::garbage()
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+
+		if(this->total_bytes == 0) return 0;
+		return (1.0 - ((double)this->live_bytes / (double)this->total_bytes));
+	}
+
+	/**
+	 * @brief Copies the live objects of every sealed segment into a single segment,
+	 * and deletes the rest.  Saving and loading are only blocked while the
+	 * new segment replaces the old ones, not while it's written.
+	 */
+	void log_store::compact()
+	{
+		std::lock_guard<std::mutex> compact_lock{this->compacting};
+		std::vector<std::pair<ID_T, location> > live;
+		std::map<std::uint64_t, int> sealed;
+		std::uint64_t target{0};
+		ID_T high{0};
+
+		{
+			std::lock_guard<std::mutex> lock{this->m};
+
+			this->roll();
+			for(auto& s : this->segments)
+			{
+				if(s.first != this->active) sealed.insert(s);
+			}
+			if(sealed.empty()) return;
+			target = sealed.rbegin()->first;
+			for(auto& e : this->index)
+			{
+				if(e.second.segment <= target) live.push_back(e);
+			}
+			high = this->hwm;
+		}
+
+		/* The sealed segments won't change, so the new one can be written without
+		 * holding the lock.  It's written to a temporary file, and renamed over the
+		 * newest sealed segment. */
+		boost::filesystem::path temp{this->segment_path(target).string() + ".tmp"};
+		int fd{::open(temp.string().c_str(), (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC), 0666)};
+		std::vector<location> moved;
+		std::uint64_t offset{0}, size{0};
+
+		if(fd < 0) throw io_error("unable to create", temp);
+		try
+		{
+			std::string out{header(supersedes, 0, 0) + header(high_water, high, 0)}, data;
+
+			offset = out.size();
+			for(auto& e : live)
+			{
+				if(!read_all(sealed[e.second.segment], data, e.second.offset, e.second.length)) throw io_error("unable to read", this->segment_path(e.second.segment));
+				out += header(object, e.first, data.size());
+				out += data;
+				moved.push_back(location{target, (offset + HEADER_SIZE), data.size()});
+				offset += (HEADER_SIZE + data.size());
+				size += (HEADER_SIZE + data.size());
+				if(out.size() >= this->buffer_size)
+				{
+					write_all(fd, out, temp);
+					out.clear();
+				}
+			}
+			write_all(fd, out, temp);
+			flush_fd(fd, temp);
+			::close(fd);
+		}
+		catch(...)
+		{
+			::close(fd);
+			boost::filesystem::remove(temp);
+			throw;
+		}
+
+		std::lock_guard<std::mutex> lock{this->m};
+		int read_fd;
+
+		if(::rename(temp.string().c_str(), this->segment_path(target).string().c_str()) != 0) throw io_error("unable to replace", this->segment_path(target));
+		read_fd = ::open(this->segment_path(target).string().c_str(), (O_RDONLY | O_CLOEXEC));
+		if(read_fd < 0) throw io_error("unable to open", this->segment_path(target));
+
+		//objects saved or removed while the segment was being written are newer than the copies:
+		for(std::size_t x{0}; x < live.size(); ++x)
+		{
+			auto it = this->index.find(live[x].first);
+			if((it != this->index.end()) && (it->second.segment == live[x].second.segment) &&
+					(it->second.offset == live[x].second.offset)) it->second = moved[x];
+		}
+		for(auto& s : sealed)
+		{
+			::close(s.second);
+			this->segments.erase(s.first);
+			if(s.first != target) boost::filesystem::remove(this->segment_path(s.first));
+		}
+		this->segments[target] = read_fd;
+
+		//recount what's live, since the new segment has no garbage, along with the segments rolled while it was written:
+		this->live_bytes = 0;
+		for(auto& e : this->index) this->live_bytes += (HEADER_SIZE + e.second.length);
+		this->total_bytes = ((2 * HEADER_SIZE) + size + this->buffer.size());
+		for(auto& s : this->segments)
+		{
+			struct stat st;
+
+			if(s.first == target) continue;
+			if(s.first == this->active) this->total_bytes += this->active_size;
+			else if(::fstat(s.second, &st) == 0) this->total_bytes += st.st_size;
+		}
+	}
+
+	/*
+	Finds the segments in the folder and rebuilds the index from them.
+	*/
+	void log_store::open()
+	{
+		std::map<std::uint64_t, boost::filesystem::path> found{list_segments(this->folder)};
+		std::uint64_t newest_compacted{0};
+
+		//a compaction that was interrupted may have left segments it replaced:
+		for(auto& s : found)
+		{
+			std::string h;
+			int fd{::open(s.second.string().c_str(), (O_RDONLY | O_CLOEXEC))};
+			char kind;
+			ID_T id;
+			std::uint64_t length;
+
+			if(fd < 0) throw io_error("unable to open", s.second);
+			if(read_all(fd, h, 0, HEADER_SIZE) && parse_header(h.data(), kind, id, length) && (kind == supersedes)) newest_compacted = s.first;
+			::close(fd);
+		}
+		for(auto it = found.begin(); it != found.end();)
+		{
+			if(it->first < newest_compacted)
+			{
+				boost::filesystem::remove(it->second);
+				it = found.erase(it);
+			}
+			else ++it;
+		}
+
+		for(auto& s : found)
+		{
+			int fd{::open(s.second.string().c_str(), (O_RDONLY | O_CLOEXEC))};
+			if(fd < 0) throw io_error("unable to open", s.second);
+			this->segments[s.first] = fd;
+			this->replay(s.first);
+		}
+
+		if(!found.empty()) this->active = found.rbegin()->first;
+		this->active_fd = ::open(this->segment_path(this->active).string().c_str(), (O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC), 0666);
+		if(this->active_fd < 0) throw io_error("unable to open", this->segment_path(this->active));
+		if(this->segments.find(this->active) == this->segments.end())
+		{
+			this->segments[this->active] = ::open(this->segment_path(this->active).string().c_str(), (O_RDONLY | O_CLOEXEC));
+		}
+
+		//a record cut short by a crash is dropped:
+		if(::ftruncate(this->active_fd, this->active_size) != 0) throw io_error("unable to truncate", this->segment_path(this->active));
+	}
+
+	/*
+	Applies the records of a segment to the index.  Stops at the first
+	incomplete record.
+	*/
+	void log_store::replay(const std::uint64_t& segment)
+	{
+		int fd{this->segments[segment]};
+		std::uint64_t offset{0};
+		std::string h;
+		char kind;
+		ID_T id;
+		std::uint64_t length;
+		struct stat st;
+
+		if(::fstat(fd, &st) != 0) throw io_error("unable to stat", this->segment_path(segment));
+		while(read_all(fd, h, offset, HEADER_SIZE) && parse_header(h.data(), kind, id, length))
+		{
+			if((offset + HEADER_SIZE + length) > (std::uint64_t)st.st_size) break;
+
+			auto it = this->index.find(id);
+			if((kind == object) || (kind == removed))
+			{
+				if(it != this->index.end())
+				{
+					this->live_bytes -= (HEADER_SIZE + it->second.length);
+					this->index.erase(it);
+				}
+				if(kind == object)
+				{
+					this->index[id] = location{segment, (offset + HEADER_SIZE), length};
+					this->live_bytes += (HEADER_SIZE + length);
+				}
+			}
+			this->hwm = std::max(this->hwm, id);
+			offset += (HEADER_SIZE + length);
+		}
+		this->total_bytes += offset;
+		this->active_size = offset;
+	}
+
+	/*
+	Adds a record to the buffer and updates the index.  Must be called while
+	holding the lock.
+	*/
+	void log_store::append(const char& kind, const ID_T& id, const std::string& data)
+	{
+		auto it = this->index.find(id);
+		std::uint64_t offset{this->active_size + this->buffer.size()};
+
+		this->buffer += header(kind, id, data.size());
+		this->buffer += data;
+		this->total_bytes += (HEADER_SIZE + data.size());
+		if(it != this->index.end())
+		{
+			this->live_bytes -= (HEADER_SIZE + it->second.length);
+			this->index.erase(it);
+		}
+		if(kind == object)
+		{
+			this->index[id] = location{this->active, (offset + HEADER_SIZE), data.size()};
+			this->live_bytes += (HEADER_SIZE + data.size());
+		}
+		this->hwm = std::max(this->hwm, id);
+
+		if(this->buffer.size() >= this->buffer_size) this->write_buffer();
+		if(this->active_size >= this->segment_size) this->roll();
+	}
+
+	void log_store::write_buffer()
+	{
+		if(this->buffer.empty()) return;
+		write_all(this->active_fd, this->buffer, this->segment_path(this->active));
+		flush_fd(this->active_fd, this->segment_path(this->active));
+		this->active_size += this->buffer.size();
+		this->buffer.clear();
+	}
+
+	/*
+	Seals the active segment and starts a new one.
+	*/
+	void log_store::roll()
+	{
+		boost::filesystem::path next{this->segment_path(this->active + 1)};
+		int write_fd, read_fd;
+
+		this->write_buffer();
+		if(this->active_size == 0) return;
+		write_fd = ::open(next.string().c_str(), (O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC), 0666);
+		if(write_fd < 0) throw io_error("unable to create", next);
+		read_fd = ::open(next.string().c_str(), (O_RDONLY | O_CLOEXEC));
+		if(read_fd < 0)
+		{
+			::close(write_fd);
+			throw io_error("unable to open", next);
+		}
+		::close(this->active_fd);
+		this->active_fd = write_fd;
+		this->segments[++(this->active)] = read_fd;
+		this->active_size = 0;
+	}
+
+	/*
+	Reads an object from its segment, or from the buffer if it hasn't been
+	written yet.  Must be called while holding the lock.
+	*/
+	bool log_store::read(const location& l, std::string& data)
+	{
+		if((l.segment == this->active) && (l.offset >= this->active_size))
+		{
+			data = this->buffer.substr((l.offset - this->active_size), l.length);
+			return true;
+		}
+
+		auto s = this->segments.find(l.segment);
+		if(s == this->segments.end()) return false;
+		return read_all(s->second, data, l.offset, l.length);
+	}
+
+	boost::filesystem::path log_store::segment_path(const std::uint64_t& n) const
+	{
+		return (this->folder / boost::filesystem::path{std::to_string(n) + ".log"});
+	}
+
+
+}
+
+/* log_compactor member functions: */
+namespace utility
+{
+	/**
+	 * @param s The store to maintain.
+	 * @param t The fraction of the log that has to be garbage before it's compacted.
+	 */
+	log_compactor::log_compactor(log_store& s, const double& t) :
+			base::worker_thread_base(),
+			store(s),
+			threshold{t},
+			m{},
+			error{}
+	{
+		this->throttle = 1;
+	}
+
+	log_compactor::~log_compactor()
+	{
+	}
+
+	void log_compactor::do_work()
+	{
+		try
+		{
+			this->store.flush();
+			if(this->store.garbage() > this->threshold) this->store.compact();
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lock{this->m};
+			this->error = std::current_exception();
+		}
+	}
+
+	/**
+	 * @brief The compactor keeps running after a flush or compaction fails, and
+	 * tries again on its next pass, so errors are kept for the caller to check.
+	 * @return The last error since the previous call (which can be rethrown with
+	 * std::rethrow_exception), or a null exception_ptr if there wasn't one.
+	 */
+	std::exception_ptr log_compactor::last_error()
+	{
+		std::lock_guard<std::mutex> lock{this->m};
+		std::exception_ptr e{this->error};
+
+		this->error = nullptr;
+		return e;
+	}
+
+
+}
@@ -0,0 +1,200 @@
+/**
+requires file_loader.hpp and worker_thread_base.hpp
+
+A log-structured alternative to storing one file per object.  Objects are appended
+to segment files ("<n>.log") within a folder, and an index of where the newest version
+of each object is kept in memory.  Saving never rewrites anything:  the new version is
+appended and the old one becomes garbage, which is reclaimed later by compact().
+
+Types stored here need only:
+
+	utility::ID_T id;
+
+	and operator<< and operator>>, like the types used with file_loader.
+
+Buffering:
+	Appends are buffered in memory, and written to the active segment when the buffer
+	fills up, when flush() is called, or when the store is destroyed.  Loads see buffered
+	objects.  If utility::sync() is true, each write of the buffer is flushed to the disk.
+	The destructor can't report an error writing the buffer, so call flush() before
+	destroying a store if it matters.
+
+Segments and compaction:
+	Once the active segment is larger than the segment size, it's sealed and a new one
+	is started.  compact() seals the active segment, and copies the live objects of every
+	sealed segment into one new segment that replaces them.  It can run while objects
+	are being saved and loaded.  log_compactor does it in the background:
+
+		utility::log_store store{folder};
+		utility::log_compactor compactor{store};
+		compactor.start();
+		...
+		compactor.halt();
+		if(compactor.last_error()) ... //a flush or compaction failed
+
+	The compactor doesn't stop when a flush or compaction fails; it keeps the error
+	for last_error(), and tries again on its next pass.
+
+Sharing:
+	The index is only kept in memory, so a folder can only be opened by one log_store
+	at a time.  The constructor throws if another one (in any process) has it open.
+
+Record format:
+	[kind : 1 byte][id : 8 bytes][length : 4 bytes][data : length bytes]
+*/
+
+#ifndef UTILITY_LOG_STORE_HPP_INCLUDED
+#define UTILITY_LOG_STORE_HPP_INCLUDED
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "file_loader.hpp"
+#include "worker_thread_base.hpp"
+
+namespace utility
+{
+	/**
+	 * @class log_store
+	 * @file log_store.hpp
+	 * @brief A folder of objects stored as an append-only log.
+	 *
+	 * This is non-copyable, and non-movable.
+	 */
+	class log_store
+	{
+	private:
+		log_store(const log_store&) = delete;
+		log_store(log_store&&) = delete;
+
+		log_store& operator=(const log_store&) = delete;
+		log_store& operator=(log_store&&) = delete;
+
+	public:
+		explicit log_store(const boost::filesystem::path&, const std::size_t& = (1 << 20), const std::uint64_t& = (64 << 20));
+		~log_store();
+
+		template<typename type> void              save(type&);
+		template<typename type> type              load(const ID_T&);
+		template<typename type> std::vector<type> load_all();
+
+		void put(const ID_T&, const std::string&);
+		bool get(const ID_T&, std::string&);
+		void remove(const ID_T&);
+		std::set<ID_T> ids();
+		ID_T next_id();
+
+		void flush();
+		void compact();
+		double garbage();
+
+	private:
+		struct location
+		{
+			std::uint64_t segment, offset, length;
+		};
+
+		void open();
+		void replay(const std::uint64_t&);
+		void append(const char&, const ID_T&, const std::string&);
+		void write_buffer();
+		void roll();
+		bool read(const location&, std::string&);
+		boost::filesystem::path segment_path(const std::uint64_t&) const;
+
+		boost::filesystem::path folder;
+		std::size_t buffer_size;
+		std::uint64_t segment_size;
+
+		std::mutex m, compacting;
+		std::unordered_map<ID_T, location> index;
+		std::map<std::uint64_t, int> segments; //segment number -> descriptor to read it
+		std::uint64_t active, active_size; //active_size doesn't include the buffer
+		int active_fd;
+		std::string buffer;
+		std::uint64_t live_bytes, total_bytes;
+		ID_T hwm;
+		int lock_fd;
+
+	};
+
+	/**
+	 * @class log_compactor
+	 * @file log_store.hpp
+	 * @brief Writes a log_store's buffer out once a second, and compacts it
+	 * when more than "threshold" of it is garbage.
+	 */
+	class log_compactor : public base::worker_thread_base
+	{
+	public:
+		explicit log_compactor(log_store&, const double& = 0.5);
+		virtual ~log_compactor();
+
+		std::exception_ptr last_error();
+
+	protected:
+		virtual void do_work();
+
+	private:
+		log_store& store;
+		double threshold;
+		std::mutex m;
+		std::exception_ptr error; //the last error do_work caught
+
+	};
+
+	/**
+	 * @brief Saves t, assigning it a new ID if it doesn't have one.
+	 */
+	template<typename type>
+	void log_store::save(type& t)
+	{
+		std::ostringstream out{std::ios::out | std::ios::binary};
+
+		if(t.id == 0) t.id = this->next_id();
+		out<< t;
+		if(out.fail()) throw std::runtime_error{"Error: unable to serialize object " + std::to_string(t.id)};
+		this->put(t.id, out.str());
+	}
+
+	template<typename type>
+	type log_store::load(const ID_T& id)
+	{
+		std::string data;
+		type t;
+
+		if(!this->get(id, data)) throw std::runtime_error{"Error: attempt to load invalid id!"};
+		std::istringstream in{data, (std::ios::in | std::ios::binary)};
+		in>> t;
+		return t;
+	}
+
+	template<typename type>
+	std::vector<type> log_store::load_all()
+	{
+		std::vector<type> t;
+		std::string data;
+
+		for(const ID_T& id : this->ids())
+		{
+			if(!this->get(id, data)) continue;
+			std::istringstream in{data, (std::ios::in | std::ios::binary)};
+			t.emplace_back();
+			in>> t.back();
+			if(t.back().id == 0) t.pop_back();
+		}
+		return t;
+	}
+
+
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef UTILITY_OBJECT_CACHE_HPP_INCLUDED
+#define UTILITY_OBJECT_CACHE_HPP_INCLUDED
+#include <boost/filesystem.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "file_loader.hpp"
+
+namespace utility
+{
+	/**
+	 * @class object_cache
+	 * @file object_cache.hpp
+	 * @brief A size-bounded LRU cache of objects loaded by utility::load, keyed
+	 * by their folder and ID.  There's one per type, and it's off until it's given a
+	 * capacity:
+	 *
+	 * utility::object_cache<type_t>::get().set_capacity(10000);
+	 *
+	 * save and remove invalidate the objects they change.  Changes made by other
+	 * processes are not seen, so don't turn it on for folders that are shared.
+	 *
+	 * The cache is split into shards, each with its own lock and its own share
+	 * of the capacity, so that threads loading different objects rarely wait on
+	 * each other.
+	 */
+	template<typename type>
+	class object_cache
+	{
+	private:
+		object_cache(const object_cache&) = delete;
+		object_cache(object_cache&&) = delete;
+
+		object_cache& operator=(const object_cache&) = delete;
+		object_cache& operator=(object_cache&&) = delete;
+
+		explicit object_cache() :
+				shards{},
+				max{0},
+				hit_count{0},
+				miss_count{0}
+		{
+		}
+
+	public:
+		static object_cache& get()
+		{
+			static object_cache cache;
+			return cache;
+		}
+
+		/**
+		 * @brief Sets the maximum number of objects held.  0 turns the cache off
+		 * and empties it.
+		 */
+		void set_capacity(const std::size_t& c)
+		{
+			this->max = c;
+			for(shard& s : this->shards)
+			{
+				std::lock_guard<std::mutex> lock{s.m};
+				s.trim(this->shard_capacity());
+			}
+		}
+
+		std::size_t capacity() const
+		{
+			return this->max;
+		}
+
+		bool enabled() const
+		{
+			return (this->max > 0);
+		}
+
+		/**
+		 * @brief Copies the cached object into t if there is one.
+		 * @return true on a hit.
+		 */
+		bool find(const boost::filesystem::path& folder, const ID_T& id, type& t)
+		{
+			if(!this->enabled()) return false;
+
+			key_type k{make_key(folder, id)};
+			shard& s(this->shard_of(k));
+			{
+				std::lock_guard<std::mutex> lock{s.m};
+				auto it = s.index.find(k);
+				if(it != s.index.end())
+				{
+					s.lru.splice(s.lru.begin(), s.lru, it->second);
+					t = it->second->second;
+					++(this->hit_count);
+					return true;
+				}
+			}
+			++(this->miss_count);
+			return false;
+		}
+
+		/**
+		 * @return A number that changes whenever an object that shares a shard
+		 * with this one is erased.  Take it before reading an object, and pass it
+		 * to insert, so that an object erased in between isn't put back.
+		 */
+		std::uint64_t generation(const boost::filesystem::path& folder, const ID_T& id)
+		{
+			key_type k{make_key(folder, id)};
+			shard& s(this->shard_of(k));
+			std::lock_guard<std::mutex> lock{s.m};
+
+			return s.generation;
+		}
+
+		void insert(const boost::filesystem::path& folder, const ID_T& id, const type& t)
+		{
+			this->put(folder, id, t, nullptr);
+		}
+
+		/**
+		 * @brief Inserts t only if nothing in its shard was erased since
+		 * generation() returned g.
+		 */
+		void insert(const boost::filesystem::path& folder, const ID_T& id, const type& t, const std::uint64_t& g)
+		{
+			this->put(folder, id, t, &g);
+		}
+
+		void erase(const boost::filesystem::path& folder, const ID_T& id)
+		{
+			if(!this->enabled()) return;
+
+			key_type k{make_key(folder, id)};
+			shard& s(this->shard_of(k));
+			std::lock_guard<std::mutex> lock{s.m};
+			auto it = s.index.find(k);
+
+			//counted even if it isn't cached, since a load may be about to insert it:
+			++(s.generation);
+			if(it == s.index.end()) return;
+			s.lru.erase(it->second);
+			s.index.erase(it);
+		}
+
+		void clear()
+		{
+			for(shard& s : this->shards)
+			{
+				std::lock_guard<std::mutex> lock{s.m};
+				s.trim(0);
+			}
+		}
+
+		std::uint64_t hits() const
+		{
+			return this->hit_count;
+		}
+
+		std::uint64_t misses() const
+		{
+			return this->miss_count;
+		}
+
+		void reset_counters()
+		{
+			this->hit_count = 0;
+			this->miss_count = 0;
+		}
+
+	private:
+		using key_type = std::pair<std::string, ID_T>;
+
+		//g is the generation t was read at, or null to insert it regardless:
+		void put(const boost::filesystem::path& folder, const ID_T& id, const type& t, const std::uint64_t* g)
+		{
+			if(!this->enabled()) return;
+
+			key_type k{make_key(folder, id)};
+			shard& s(this->shard_of(k));
+			std::lock_guard<std::mutex> lock{s.m};
+			auto it = s.index.find(k);
+
+			if((g != nullptr) && (*g != s.generation)) return;
+			if(it != s.index.end())
+			{
+				it->second->second = t;
+				s.lru.splice(s.lru.begin(), s.lru, it->second);
+				return;
+			}
+			s.lru.emplace_front(k, t);
+			s.index.emplace(std::move(k), s.lru.begin());
+			s.trim(this->shard_capacity());
+		}
+
+
+		struct key_hash
+		{
+			std::size_t operator()(const key_type& k) const
+			{
+				std::size_t h{std::hash<std::string>{}(k.first)};
+				return (h ^ (std::hash<ID_T>{}(k.second) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+			}
+		};
+
+		struct shard
+		{
+			void trim(const std::size_t& c)
+			{
+				while(this->lru.size() > c)
+				{
+					this->index.erase(this->lru.back().first);
+					this->lru.pop_back();
+				}
+			}
+
+			std::mutex m;
+			std::uint64_t generation{0}; //how many erases there have been
+			std::list<std::pair<key_type, type> > lru; //most recently used first
+			std::unordered_map<key_type, typename std::list<std::pair<key_type, type> >::iterator, key_hash> index;
+		};
+
+		static constexpr std::size_t SHARDS{16};
+
+		static key_type make_key(const boost::filesystem::path& folder, const ID_T& id)
+		{
+			return key_type{folder.lexically_normal().string(), id};
+		}
+
+		shard& shard_of(const key_type& k)
+		{
+			return this->shards[(key_hash{}(k) % SHARDS)];
+		}
+
+		std::size_t shard_capacity() const
+		{
+			return ((this->max + SHARDS - 1) / SHARDS);
+		}
+
+		std::array<shard, SHARDS> shards;
+		std::atomic<std::size_t> max;
+		std::atomic<std::uint64_t> hit_count, miss_count;
+
+	};
+
+
+}
+
+#endif
@@ -0,0 +1,332 @@
+#ifndef UTILITY_SCHEMA_HPP_INCLUDED
+#define UTILITY_SCHEMA_HPP_INCLUDED
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "file_loader.hpp"
+
+namespace utility
+{
+	/**
+	 * @brief Describes one member of a type that's serialized by schema.
+	 * The tag identifies the member within a file, so it must never change, and
+	 * must never be reused for another member once the member is removed.
+	 * Members marked basic are the ones loaded by basic().
+	 */
+	template<typename owner, typename member_t>
+	struct field
+	{
+		std::uint16_t tag;
+		member_t owner::* member;
+		bool basic;
+	};
+
+	template<typename owner, typename member_t>
+	constexpr field<owner, member_t> make_field(const std::uint16_t& tag, member_t owner::* member, const bool& basic = false)
+	{
+		return field<owner, member_t>{tag, member, basic};
+	}
+
+	namespace
+	{
+		template<typename type, typename = void> struct codec;
+		template<typename type, typename = void> struct has_fields : std::false_type {};
+		template<typename type> struct has_fields<type, decltype(void(type::fields()))> : std::true_type {};
+
+		template<typename type> void append(std::string&, const type&);
+		template<typename type> void write_fields(std::string&, const type&);
+		template<typename type> void read_fields(std::istream&, type&, const bool& = false);
+
+
+
+		template<typename type>
+		inline void append(std::string& out, const type& t)
+		{
+			out.append(reinterpret_cast<const char*>(&t), sizeof(t));
+		}
+
+		/*
+		Numbers and enums are stored as their bytes.  If the size stored doesn't match,
+		the member's type was changed, so it keeps its default.
+		*/
+		template<typename type>
+		struct codec<type, typename std::enable_if<(std::is_arithmetic<type>::value || std::is_enum<type>::value)>::type>
+		{
+			static void write(std::string& out, const type& t)
+			{
+				append(out, t);
+			}
+
+			static void read(std::istream& in, const std::uint32_t& length, type& t)
+			{
+				if(length == sizeof(t)) in.read(reinterpret_cast<char*>(&t), sizeof(t));
+				else in.ignore(length);
+			}
+		};
+
+		template<>
+		struct codec<std::string>
+		{
+			static void write(std::string& out, const std::string& s)
+			{
+				out.append(s);
+			}
+
+			static void read(std::istream& in, const std::uint32_t& length, std::string& s)
+			{
+				s.resize(length);
+				if(length > 0) in.read(&s[0], length);
+			}
+		};
+
+		/*
+		Vectors of numbers are stored as one block, and read directly into the vector.
+		*/
+		template<typename type>
+		struct codec<std::vector<type>, typename std::enable_if<std::is_arithmetic<type>::value>::type>
+		{
+			static void write(std::string& out, const std::vector<type>& v)
+			{
+				if(!v.empty()) out.append(reinterpret_cast<const char*>(v.data()), (v.size() * sizeof(type)));
+			}
+
+			static void read(std::istream& in, const std::uint32_t& length, std::vector<type>& v)
+			{
+				v.clear();
+				if((length % sizeof(type)) != 0)
+				{
+					in.ignore(length);
+					return;
+				}
+				v.resize(length / sizeof(type));
+				if(!v.empty()) in.read(reinterpret_cast<char*>(v.data()), length);
+			}
+		};
+
+		/*
+		std::vector<bool> has no data() to read into, so it's stored a byte per element,
+		the way any other vector of bools would be.
+		*/
+		template<>
+		struct codec<std::vector<bool> >
+		{
+			static void write(std::string& out, const std::vector<bool>& v)
+			{
+				for(const bool b : v) out.push_back(b ? 1 : 0);
+			}
+
+			static void read(std::istream& in, const std::uint32_t& length, std::vector<bool>& v)
+			{
+				std::string bytes(length, '\0');
+
+				v.clear();
+				if((length > 0) && !in.read(&bytes[0], length)) return;
+				for(const char c : bytes) v.push_back(c != 0);
+			}
+		};
+
+		/*
+		Other vectors store each element with its length.
+		*/
+		template<typename type>
+		struct codec<std::vector<type>, typename std::enable_if<!std::is_arithmetic<type>::value>::type>
+		{
+			static void write(std::string& out, const std::vector<type>& v)
+			{
+				std::string element;
+
+				for(const type& t : v)
+				{
+					element.clear();
+					codec<type>::write(element, t);
+					append(out, static_cast<std::uint32_t>(element.size()));
+					out.append(element);
+				}
+			}
+
+			static void read(std::istream& in, std::uint32_t length, std::vector<type>& v)
+			{
+				std::uint32_t size;
+
+				v.clear();
+				while((length >= sizeof(size)) && in.read(reinterpret_cast<char*>(&size), sizeof(size)) && (size <= (length - sizeof(size))))
+				{
+					v.emplace_back();
+					codec<type>::read(in, size, v.back());
+					length -= (sizeof(size) + size);
+				}
+			}
+		};
+
+		/*
+		Members that have fields of their own are stored the same way as the object.
+		*/
+		template<typename type>
+		struct codec<type, typename std::enable_if<has_fields<type>::value>::type>
+		{
+			static void write(std::string& out, const type& t)
+			{
+				write_fields(out, t);
+			}
+
+			static void read(std::istream& in, const std::uint32_t&, type& t)
+			{
+				read_fields(in, t);
+			}
+		};
+
+		template<typename type, typename member_t>
+		void write_field(std::string& out, std::string& value, const type& t, const field<type, member_t>& f)
+		{
+			value.clear();
+			codec<member_t>::write(value, (t.*(f.member)));
+			append(out, f.tag);
+			append(out, static_cast<std::uint32_t>(value.size()));
+			out.append(value);
+		}
+
+		template<typename type, typename fields_t, std::size_t... i>
+		void write_fields(std::string& out, const type& t, const fields_t& fields, std::index_sequence<i...>)
+		{
+			std::string value;
+
+			append(out, static_cast<std::uint16_t>(sizeof...(i)));
+			(void)std::initializer_list<int>{(write_field(out, value, t, std::get<i>(fields)), 0)...};
+		}
+
+		/*
+		[count : 2 bytes] followed by count fields of [tag : 2 bytes][length : 4 bytes][value]
+		*/
+		template<typename type>
+		inline void write_fields(std::string& out, const type& t)
+		{
+			write_fields(out, t, type::fields(), std::make_index_sequence<std::tuple_size<decltype(type::fields())>::value>{});
+		}
+
+		template<typename type, typename member_t>
+		void read_field(std::istream& in, type& t, const field<type, member_t>& f, const std::uint16_t& tag, const std::uint32_t& length,
+				const bool& basic_only, bool& found, std::size_t& basic_found)
+		{
+			if(found || (f.tag != tag) || (basic_only && !f.basic)) return;
+			codec<member_t>::read(in, length, (t.*(f.member)));
+			found = true;
+			if(f.basic) ++basic_found;
+		}
+
+		template<typename type, typename fields_t, std::size_t... i>
+		void read_fields(std::istream& in, type& t, const bool& basic_only, const fields_t& fields, std::index_sequence<i...>)
+		{
+			std::uint16_t count, tag;
+			std::uint32_t length;
+			std::size_t basic_found{0}, basic_count{0};
+
+			(void)std::initializer_list<int>{(basic_count += (std::get<i>(fields).basic ? 1 : 0), 0)...};
+			if(!in.read(reinterpret_cast<char*>(&count), sizeof(count))) return;
+			for(std::uint16_t x{0}; (x < count) && in.good(); ++x)
+			{
+				bool found{false};
+
+				if(basic_only && (basic_found == basic_count)) return; //everything basic() needs has been read
+				if(!in.read(reinterpret_cast<char*>(&tag), sizeof(tag)) || !in.read(reinterpret_cast<char*>(&length), sizeof(length))) return;
+				(void)std::initializer_list<int>{(read_field(in, t, std::get<i>(fields), tag, length, basic_only, found, basic_found), 0)...};
+				if(!found) in.ignore(length); //removed from the type, or not needed
+			}
+		}
+
+		/*
+		Fields that aren't in the file keep their default values, and fields in the file
+		that the type doesn't have anymore are skipped.
+		*/
+		template<typename type>
+		inline void read_fields(std::istream& in, type& t, const bool& basic_only)
+		{
+			read_fields(in, t, basic_only, type::fields(), std::make_index_sequence<std::tuple_size<decltype(type::fields())>::value>{});
+		}
+
+
+	}
+
+	/**
+	 * @class schema
+	 * @file schema.hpp
+	 * @brief Generates load_id, basic and the stream operators of a type used with
+	 * file_loader from a list of its members, so that they don't have to be written by
+	 * hand and kept in agreement with each other.
+	 *
+	 * Example:
+	 *
+	 * struct account : utility::schema<account>
+	 * {
+	 *     static constexpr const char* const EXTENSION{".acct"};
+	 *     static boost::filesystem::path folder();
+	 *
+	 *     static constexpr auto fields()
+	 *     {
+	 *         return std::make_tuple(
+	 *                 utility::make_field(1, &account::name, true),
+	 *                 utility::make_field(2, &account::balance),
+	 *                 utility::make_field(3, &account::history));
+	 *     }
+	 *
+	 *     utility::ID_T id{0};
+	 *     std::string name;
+	 *     double balance{0};
+	 *     std::vector<transaction> history; //transaction has fields() too
+	 * };
+	 *
+	 * Objects are stored as [id : 8 bytes][count : 2 bytes], followed by each
+	 * field as [tag : 2 bytes][length : 4 bytes][value].  load_id reads only the
+	 * ID, and basic stops reading once it has every field marked basic, so those
+	 * fields should be listed first.  Values are read straight into the members,
+	 * without being copied through a buffer.
+	 *
+	 * Fields may be added and removed freely:  an object saved before a field was
+	 * added loads with the member's default value, and fields that aren't listed
+	 * anymore are skipped.  To change a member's type, give it a new tag.
+	 *
+	 * Members may be numbers, enums, std::string, other types with fields(), and
+	 * std::vector of any of those.
+	 */
+	template<typename type>
+	struct schema
+	{
+		static ID_T load_id(std::istream& in)
+		{
+			ID_T id{0};
+			in.read(reinterpret_cast<char*>(&id), sizeof(id));
+			return (in.good() ? id : 0);
+		}
+
+		static type basic(std::istream& in)
+		{
+			type t;
+			if(in.read(reinterpret_cast<char*>(&(t.id)), sizeof(t.id))) read_fields(in, t, true);
+			return t;
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, const type& t)
+		{
+			std::string data;
+
+			append(data, static_cast<ID_T>(t.id));
+			write_fields(data, t);
+			return out.write(data.data(), data.size());
+		}
+
+		friend std::istream& operator>>(std::istream& in, type& t)
+		{
+			if(in.read(reinterpret_cast<char*>(&(t.id)), sizeof(t.id))) read_fields(in, t);
+			return in;
+		}
+	};
+
+
+}
+
+#endif
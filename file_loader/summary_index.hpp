@@ -0,0 +1,119 @@
+#ifndef UTILITY_SUMMARY_INDEX_HPP_INCLUDED
+#define UTILITY_SUMMARY_INDEX_HPP_INCLUDED
+#include <boost/filesystem.hpp>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "file_loader.hpp"
+
+namespace utility
+{
+	/**
+	 * @class summary_index
+	 * @file summary_index.hpp
+	 * @brief Orders the basic() projections of a folder's objects by a key taken
+	 * from each one, so they can be sorted and filtered without loading them again.
+	 * It's built with load_basic, so if the folder has a summary cache (see build_summary)
+	 * none of the object files are opened.  Call refresh() to pick up changes.
+	 *
+	 * Example:
+	 *
+	 * utility::summary_index<account, std::string> by_name{[](const account& a){ return a.name; }};
+	 * for(const account& a : by_name.range("A", "B")) ...
+	 *
+	 * load_basic<type> must be instantiated.
+	 */
+	template<typename type, typename key_type>
+	class summary_index
+	{
+	public:
+		using key_function = std::function<key_type(const type&)>;
+
+		summary_index(const key_function& k, const boost::filesystem::path& f = type::folder()) :
+				key{k},
+				folder{f},
+				index{}
+		{
+			this->refresh();
+		}
+
+		/**
+		 * @brief Rebuilds the index from the folder.
+		 */
+		void refresh()
+		{
+			this->index.clear();
+			for(type& t : load_basic<type>(this->folder))
+			{
+				key_type k{this->key(t)};
+				this->index.emplace(std::move(k), std::move(t));
+			}
+		}
+
+		/**
+		 * @return Every object whose key is equal to k.
+		 */
+		std::vector<type> find(const key_type& k) const
+		{
+			auto r = this->index.equal_range(k);
+			return this->collect(r.first, r.second);
+		}
+
+		/**
+		 * @return Every object whose key is within [low, high), in order.
+		 */
+		std::vector<type> range(const key_type& low, const key_type& high) const
+		{
+			if(high < low) return std::vector<type>{};
+			return this->collect(this->index.lower_bound(low), this->index.lower_bound(high));
+		}
+
+		/**
+		 * @return Every object, sorted by its key.
+		 */
+		std::vector<type> sorted(const bool& ascending = true) const
+		{
+			std::vector<type> t{this->collect(this->index.begin(), this->index.end())};
+			if(!ascending) t.assign(t.rbegin(), t.rend());
+			return t;
+		}
+
+		/**
+		 * @return Every object whose key satisfies the predicate, sorted by key.
+		 */
+		std::vector<type> filter(const std::function<bool(const key_type&)>& pred) const
+		{
+			std::vector<type> t;
+			for(auto& i : this->index)
+			{
+				if(pred(i.first)) t.push_back(i.second);
+			}
+			return t;
+		}
+
+		std::size_t size() const
+		{
+			return this->index.size();
+		}
+
+	private:
+		template<typename iterator_type>
+		std::vector<type> collect(iterator_type beg, const iterator_type& end) const
+		{
+			std::vector<type> t;
+			for(; beg != end; ++beg) t.push_back(beg->second);
+			return t;
+		}
+
+		key_function key;
+		boost::filesystem::path folder;
+		std::multimap<key_type, type> index;
+
+	};
+
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define WORKER_THREAD_BASE_HPP_INCLUDED
 #include <thread>
 #include <memory>
+#include <atomic>
 
 namespace base
 {
@@ -48,7 +49,7 @@ namespace base
         unsigned int throttle; //how many times per second do_work is called
         
     private:
-        bool running, stopped;
+        std::atomic<bool> running, stopped; //read by halt() while the worker sets them
         std::shared_ptr<std::thread> worker, joiner;
         
     } worker_thread_base;